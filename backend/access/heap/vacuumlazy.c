@@ -4,23 +4,26 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead tuple
- * TIDs.  We want to ensure we can vacuum even the very largest relations with
- * finite memory space usage.  To do that, we set upper bounds on the number of
- * tuples we will keep track of at once.
+ * The major space usage for LAZY VACUUM is storage for the dead tuple TIDs.
+ * We want to ensure we can vacuum even the very largest relations with
+ * finite memory space usage.  To do that, we set upper bounds on the amount
+ * of memory used to keep track of dead tuples at once.
  *
  * We are willing to use at most maintenance_work_mem (or perhaps
  * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
+ * initially allocate a TID store of that size, with an upper limit that
  * depends on table size (this limit ensures we don't allocate a huge area
- * uselessly for vacuuming small tables).  If the array threatens to overflow,
- * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * uselessly for vacuuming small tables).  The TIDs are stored per heap block,
+ * as either a list of offsets or an offset bitmap, whichever is smaller, so
+ * pages with many dead tuples take much less space than a plain TID array.
+ * If the store threatens to overflow, we suspend the heap scan phase and
+ * perform a pass of index cleanup and page compaction, then resume the heap
+ * scan with an empty TID store.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * the TID store, just enough to hold the dead tuples of one page.
  *
  * Lazy vacuum supports parallel execution with parallel worker processes.  In
  * a parallel vacuum, we perform both index vacuum and index cleanup with
@@ -70,6 +73,7 @@
 #include "miscadmin.h"
 #include "optimizer/paths.h"
 #include "pgstat.h"
+#include "port/pg_bitutils.h"
 #include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
@@ -124,13 +128,6 @@
 #define VACUUM_FSM_EVERY_PAGES \
 	((BlockNumber) (((uint64) 8 * 1024 * 1024 * 1024) / BLCKSZ))
 
-/*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
- */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
-
 /*
  * Before we consider skipping a page that's marked as clean in
  * visibility map, we must've seen at least this many clean pages.
@@ -174,24 +171,54 @@ typedef enum
 /*
  * LVDeadTuples stores the dead tuple TIDs collected during the heap scan.
  * This is allocated in the DSM segment in parallel mode and in local memory
- * in non-parallel mode.
+ * in non-parallel mode, so it must not contain any pointers.
+ *
+ * The TIDs are grouped by heap block.  Each block that has dead tuples gets
+ * an LVDeadBlock entry; the entries grow upwards from the start of the space,
+ * in block number order (the heap scan visits the blocks in order).  The
+ * offsets of each block are kept in an area of uint16 words that grows
+ * downwards from the end of the space.  A block's offsets are stored either
+ * as a sorted list of offset numbers, or as a bitmap with one bit per offset
+ * number, whichever takes fewer words.
  */
+typedef struct LVDeadBlock
+{
+	BlockNumber blkno;
+	/* end of this block's words, counted from the end of the space */
+	uint32		end;
+} LVDeadBlock;
+
+/* Flag in LVDeadBlock.end: the block's offsets are stored as a bitmap */
+#define DEADBLOCK_BITMAP		0x80000000
+#define DEADBLOCK_END(db)		((db)->end & ~DEADBLOCK_BITMAP)
+
 typedef struct LVDeadTuples
 {
-	int			max_tuples;		/* # slots allocated in array */
-	int			num_tuples;		/* current # of entries */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	ItemPointerData itemptrs[FLEXIBLE_ARRAY_MEMBER];	/* array of
-														 * ItemPointerData */
+	Size		max_bytes;		/* size of the space, in bytes */
+	int64		num_tuples;		/* total # of TIDs stored */
+	int			num_blocks;		/* # of LVDeadBlock entries */
+	uint32		used_words;		/* # of offset words used */
+	/* the space, LVDeadBlocks at the start, offset words at the end */
+	LVDeadBlock blocks[FLEXIBLE_ARRAY_MEMBER];
 } LVDeadTuples;
 
-/* The dead tuple space consists of LVDeadTuples and dead tuple TIDs */
-#define SizeOfDeadTuples(cnt) \
-	add_size(offsetof(LVDeadTuples, itemptrs), \
-			 mul_size(sizeof(ItemPointerData), cnt))
-#define MAXDEADTUPLES(max_size) \
-		(((max_size) - offsetof(LVDeadTuples, itemptrs)) / sizeof(ItemPointerData))
+/* Words needed to store any page's dead tuples as a bitmap */
+#define DEADBLOCK_BITMAP_WORDS	(MaxHeapTuplesPerPage / 16 + 1)
+
+/*
+ * Worst-case space needed to record the dead tuples of one heap page.  This
+ * also provides an upper limit to memory allocated when vacuuming small
+ * tables.
+ */
+#define DEADBLOCK_MAX_SPACE \
+	(sizeof(LVDeadBlock) + DEADBLOCK_BITMAP_WORDS * sizeof(uint16))
+
+/* Largest space whose word offsets fit in LVDeadBlock.end */
+#define DEADTUPLES_MAX_SPACE \
+	((Size) (DEADBLOCK_BITMAP - 1) * sizeof(uint16))
+
+#define SizeOfDeadTuples(space) \
+	add_size(offsetof(LVDeadTuples, blocks), (space))
 
 /*
  * Shared information among parallel workers.  So this is allocated in the DSM
@@ -444,12 +471,16 @@ static bool should_attempt_truncation(LVRelState *vacrel);
 static void lazy_truncate_heap(LVRelState *vacrel);
 static BlockNumber count_nondeletable_pages(LVRelState *vacrel,
 											bool *lock_waiter_detected);
-static long compute_max_dead_tuples(BlockNumber relblocks, bool hasindex);
+static Size compute_dead_tuples_space(BlockNumber relblocks, bool hasindex);
 static void lazy_space_alloc(LVRelState *vacrel, int nworkers,
 							 BlockNumber relblocks);
 static void lazy_space_free(LVRelState *vacrel);
+static void dead_tuples_reset(LVDeadTuples *dead_tuples);
+static void dead_tuples_add_block(LVDeadTuples *dead_tuples, BlockNumber blkno,
+								  OffsetNumber *offsets, int noffsets);
+static int	dead_tuples_get_offsets(LVDeadTuples *dead_tuples, int blockindex,
+									OffsetNumber *offsets);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
 static bool heap_page_is_all_visible(LVRelState *vacrel, Buffer buf,
 									 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 static int	compute_parallel_vacuum_workers(LVRelState *vacrel,
@@ -982,7 +1013,8 @@ lazy_scan_heap(LVRelState *vacrel, VacuumParams *params, bool aggressive)
 	/* Report that we're scanning the heap, advertising total # of blocks */
 	initprog_val[0] = PROGRESS_VACUUM_PHASE_SCAN_HEAP;
 	initprog_val[1] = nblocks;
-	initprog_val[2] = dead_tuples->max_tuples;
+	/* report the capacity as if the TIDs were kept in a plain array */
+	initprog_val[2] = dead_tuples->max_bytes / sizeof(ItemPointerData);
 	pgstat_progress_update_multi_param(3, initprog_index, initprog_val);
 
 	/*
@@ -1173,7 +1205,9 @@ lazy_scan_heap(LVRelState *vacrel, VacuumParams *params, bool aggressive)
 		 * dead-tuple TIDs, pause and do a cycle of vacuuming before we tackle
 		 * this page.
 		 */
-		if ((dead_tuples->max_tuples - dead_tuples->num_tuples) < MaxHeapTuplesPerPage &&
+		if (dead_tuples->max_bytes -
+			dead_tuples->num_blocks * sizeof(LVDeadBlock) -
+			dead_tuples->used_words * sizeof(uint16) < DEADBLOCK_MAX_SPACE &&
 			dead_tuples->num_tuples > 0)
 		{
 			/*
@@ -1406,7 +1440,7 @@ lazy_scan_heap(LVRelState *vacrel, VacuumParams *params, bool aggressive)
 				lazy_vacuum_heap_page(vacrel, blkno, buf, 0, &vmbuffer);
 
 				/* Forget the now-vacuumed tuples */
-				dead_tuples->num_tuples = 0;
+				dead_tuples_reset(dead_tuples);
 
 				/*
 				 * Periodically perform FSM vacuuming to make newly-freed
@@ -2042,22 +2076,14 @@ retry:
 	if (lpdead_items > 0)
 	{
 		LVDeadTuples *dead_tuples = vacrel->dead_tuples;
-		ItemPointerData tmp;
 
 		Assert(!prunestate->all_visible);
 		Assert(prunestate->has_lpdead_items);
 
 		vacrel->lpdead_item_pages++;
 
-		ItemPointerSetBlockNumber(&tmp, blkno);
-
-		for (int i = 0; i < lpdead_items; i++)
-		{
-			ItemPointerSetOffsetNumber(&tmp, deadoffsets[i]);
-			dead_tuples->itemptrs[dead_tuples->num_tuples++] = tmp;
-		}
+		dead_tuples_add_block(dead_tuples, blkno, deadoffsets, lpdead_items);
 
-		Assert(dead_tuples->num_tuples <= dead_tuples->max_tuples);
 		pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
 									 dead_tuples->num_tuples);
 	}
@@ -2096,7 +2122,7 @@ lazy_vacuum(LVRelState *vacrel)
 	if (!vacrel->do_index_vacuuming)
 	{
 		Assert(!vacrel->do_index_cleanup);
-		vacrel->dead_tuples->num_tuples = 0;
+		dead_tuples_reset(vacrel->dead_tuples);
 		return;
 	}
 
@@ -2153,7 +2179,9 @@ lazy_vacuum(LVRelState *vacrel)
 		 */
 		threshold = (double) vacrel->rel_pages * BYPASS_THRESHOLD_PAGES;
 		bypass = (vacrel->lpdead_item_pages < threshold &&
-				  vacrel->lpdead_items < MAXDEADTUPLES(32L * 1024L * 1024L));
+				  vacrel->dead_tuples->num_blocks * sizeof(LVDeadBlock) +
+				  vacrel->dead_tuples->used_words * sizeof(uint16) <
+				  32L * 1024L * 1024L);
 	}
 
 	if (bypass)
@@ -2203,7 +2231,7 @@ lazy_vacuum(LVRelState *vacrel)
 	 * Forget the LP_DEAD items that we just vacuumed (or just decided to not
 	 * vacuum)
 	 */
-	vacrel->dead_tuples->num_tuples = 0;
+	dead_tuples_reset(vacrel->dead_tuples);
 }
 
 /*
@@ -2296,7 +2324,7 @@ lazy_vacuum_all_indexes(LVRelState *vacrel)
 /*
  *	lazy_vacuum_heap_rel() -- second pass over the heap for two pass strategy
  *
- * This routine marks LP_DEAD items in vacrel->dead_tuples array as LP_UNUSED.
+ * This routine marks LP_DEAD items in vacrel->dead_tuples as LP_UNUSED.
  * Pages that never had lazy_scan_prune record LP_DEAD items are not visited
  * at all.
  *
@@ -2314,7 +2342,7 @@ lazy_vacuum_all_indexes(LVRelState *vacrel)
 static void
 lazy_vacuum_heap_rel(LVRelState *vacrel)
 {
-	int			tupindex;
+	int64		tupcount;
 	BlockNumber vacuumed_pages;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
@@ -2336,8 +2364,9 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 	pg_rusage_init(&ru0);
 	vacuumed_pages = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrel->dead_tuples->num_tuples)
+	tupcount = 0;
+	for (int blockindex = 0; blockindex < vacrel->dead_tuples->num_blocks;
+		 blockindex++)
 	{
 		BlockNumber tblk;
 		Buffer		buf;
@@ -2346,13 +2375,13 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrel->dead_tuples->itemptrs[tupindex]);
+		tblk = vacrel->dead_tuples->blocks[blockindex].blkno;
 		vacrel->blkno = tblk;
 		buf = ReadBufferExtended(vacrel->rel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vacrel->bstrategy);
 		LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
-		tupindex = lazy_vacuum_heap_page(vacrel, tblk, buf, tupindex,
-										 &vmbuffer);
+		tupcount += lazy_vacuum_heap_page(vacrel, tblk, buf, blockindex,
+										  &vmbuffer);
 
 		/* Now that we've vacuumed the page, record its available space */
 		page = BufferGetPage(buf);
@@ -2376,14 +2405,14 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 	 * We set all LP_DEAD items from the first heap pass to LP_UNUSED during
 	 * the second heap pass.  No more, no less.
 	 */
-	Assert(tupindex > 0);
+	Assert(tupcount > 0);
 	Assert(vacrel->num_index_scans > 1 ||
-		   (tupindex == vacrel->lpdead_items &&
+		   (tupcount == vacrel->lpdead_items &&
 			vacuumed_pages == vacrel->lpdead_item_pages));
 
 	ereport(elevel,
 			(errmsg("table \"%s\": removed %lld dead item identifiers in %u pages",
-					vacrel->relname, (long long ) tupindex, vacuumed_pages),
+					vacrel->relname, (long long ) tupcount, vacuumed_pages),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 
 	/* Revert to the previous phase information for error traceback */
@@ -2391,15 +2420,14 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 }
 
 /*
- *	lazy_vacuum_heap_page() -- free page's LP_DEAD items listed in the
- *						  vacrel->dead_tuples array.
+ *	lazy_vacuum_heap_page() -- free page's LP_DEAD items listed in
+ *						  vacrel->dead_tuples.
  *
  * Caller must have an exclusive buffer lock on the buffer (though a
  * super-exclusive lock is also acceptable).
  *
- * tupindex is the index in vacrel->dead_tuples of the first dead tuple for
- * this page.  We assume the rest follow sequentially.  The return value is
- * the first tupindex after the tuples of this page.
+ * blockindex is the index of this page's entry in vacrel->dead_tuples.  The
+ * return value is the number of items set unused.
  *
  * Prior to PostgreSQL 14 there were rare cases where this routine had to set
  * tuples with storage to unused.  These days it is strictly responsible for
@@ -2410,12 +2438,12 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
  */
 static int
 lazy_vacuum_heap_page(LVRelState *vacrel, BlockNumber blkno, Buffer buffer,
-					  int tupindex, Buffer *vmbuffer)
+					  int blockindex, Buffer *vmbuffer)
 {
 	LVDeadTuples *dead_tuples = vacrel->dead_tuples;
 	Page		page = BufferGetPage(buffer);
 	OffsetNumber unused[MaxHeapTuplesPerPage];
-	int			uncnt = 0;
+	int			uncnt;
 	TransactionId visibility_cutoff_xid;
 	bool		all_frozen;
 	LVSavedErrInfo saved_err_info;
@@ -2429,23 +2457,17 @@ lazy_vacuum_heap_page(LVRelState *vacrel, BlockNumber blkno, Buffer buffer,
 							 VACUUM_ERRCB_PHASE_VACUUM_HEAP, blkno,
 							 InvalidOffsetNumber);
 
+	Assert(dead_tuples->blocks[blockindex].blkno == blkno);
+	uncnt = dead_tuples_get_offsets(dead_tuples, blockindex, unused);
+
 	START_CRIT_SECTION();
 
-	for (; tupindex < dead_tuples->num_tuples; tupindex++)
+	for (int i = 0; i < uncnt; i++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
-		ItemId		itemid;
-
-		tblk = ItemPointerGetBlockNumber(&dead_tuples->itemptrs[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&dead_tuples->itemptrs[tupindex]);
-		itemid = PageGetItemId(page, toff);
+		ItemId		itemid = PageGetItemId(page, unused[i]);
 
 		Assert(ItemIdIsDead(itemid) && !ItemIdHasStorage(itemid));
 		ItemIdSetUnused(itemid);
-		unused[uncnt++] = toff;
 	}
 
 	Assert(uncnt > 0);
@@ -2520,7 +2542,7 @@ lazy_vacuum_heap_page(LVRelState *vacrel, BlockNumber blkno, Buffer buffer,
 
 	/* Revert to the previous phase information for error traceback */
 	restore_vacuum_error_info(vacrel, &saved_err_info);
-	return tupindex;
+	return uncnt;
 }
 
 /*
@@ -3060,8 +3082,9 @@ lazy_vacuum_one_index(Relation indrel, IndexBulkDeleteResult *istat,
 							  (void *) vacrel->dead_tuples);
 
 	ereport(elevel,
-			(errmsg("scanned index \"%s\" to remove %d row versions",
-					vacrel->indname, vacrel->dead_tuples->num_tuples),
+			(errmsg("scanned index \"%s\" to remove %lld row versions",
+					vacrel->indname,
+					(long long) vacrel->dead_tuples->num_tuples),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 
 	/* Revert to the previous phase information for error traceback */
@@ -3446,33 +3469,32 @@ count_nondeletable_pages(LVRelState *vacrel, bool *lock_waiter_detected)
 }
 
 /*
- * Return the maximum number of dead tuples we can record.
+ * Return the amount of space, in bytes, to use for recording dead tuples.
  */
-static long
-compute_max_dead_tuples(BlockNumber relblocks, bool hasindex)
+static Size
+compute_dead_tuples_space(BlockNumber relblocks, bool hasindex)
 {
-	long		maxtuples;
+	Size		space;
 	int			vac_work_mem = IsAutoVacuumWorkerProcess() &&
 	autovacuum_work_mem != -1 ?
 	autovacuum_work_mem : maintenance_work_mem;
 
 	if (hasindex)
 	{
-		maxtuples = MAXDEADTUPLES(vac_work_mem * 1024L);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MAXDEADTUPLES(MaxAllocSize));
+		space = (Size) vac_work_mem * 1024;
+		space = Min(space, DEADTUPLES_MAX_SPACE);
 
 		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+		if ((BlockNumber) (space / DEADBLOCK_MAX_SPACE) > relblocks)
+			space = relblocks * DEADBLOCK_MAX_SPACE;
 
 		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
+		space = Max(space, DEADBLOCK_MAX_SPACE);
 	}
 	else
-		maxtuples = MaxHeapTuplesPerPage;
+		space = DEADBLOCK_MAX_SPACE;
 
-	return maxtuples;
+	return space;
 }
 
 /*
@@ -3484,7 +3506,7 @@ static void
 lazy_space_alloc(LVRelState *vacrel, int nworkers, BlockNumber nblocks)
 {
 	LVDeadTuples *dead_tuples;
-	long		maxtuples;
+	Size		space;
 
 	/*
 	 * Initialize state for a parallel vacuum.  As of now, only one worker can
@@ -3516,11 +3538,12 @@ lazy_space_alloc(LVRelState *vacrel, int nworkers, BlockNumber nblocks)
 			return;
 	}
 
-	maxtuples = compute_max_dead_tuples(nblocks, vacrel->nindexes > 0);
+	space = compute_dead_tuples_space(nblocks, vacrel->nindexes > 0);
 
-	dead_tuples = (LVDeadTuples *) palloc(SizeOfDeadTuples(maxtuples));
-	dead_tuples->num_tuples = 0;
-	dead_tuples->max_tuples = (int) maxtuples;
+	dead_tuples = (LVDeadTuples *)
+		MemoryContextAllocHuge(CurrentMemoryContext, SizeOfDeadTuples(space));
+	dead_tuples->max_bytes = space;
+	dead_tuples_reset(dead_tuples);
 
 	vacrel->dead_tuples = dead_tuples;
 }
@@ -3541,72 +3564,185 @@ lazy_space_free(LVRelState *vacrel)
 	end_parallel_vacuum(vacrel);
 }
 
+/*
+ * Offset words of a dead tuple store, indexed so that the words of a block
+ * entry ending at 'end' start at OFFSET_WORDS(dt) - end.
+ */
+#define OFFSET_WORDS(dt) \
+	((uint16 *) ((char *) (dt)->blocks + (dt)->max_bytes))
+
+/*
+ *	dead_tuples_reset() -- forget all TIDs in the dead tuple store
+ */
+static void
+dead_tuples_reset(LVDeadTuples *dead_tuples)
+{
+	dead_tuples->num_tuples = 0;
+	dead_tuples->num_blocks = 0;
+	dead_tuples->used_words = 0;
+}
+
+/*
+ *	dead_tuples_add_block() -- remember the dead tuples of a heap page
+ *
+ * offsets must be sorted, and blkno must be higher than that of any block
+ * added since the last reset.  The caller must have made sure that there's
+ * at least DEADBLOCK_MAX_SPACE bytes of free space.
+ */
+static void
+dead_tuples_add_block(LVDeadTuples *dead_tuples, BlockNumber blkno,
+					  OffsetNumber *offsets, int noffsets)
+{
+	LVDeadBlock *db;
+	uint16	   *words;
+	int			nbitmapwords;
+
+	Assert(noffsets > 0);
+	Assert(dead_tuples->num_blocks == 0 ||
+		   dead_tuples->blocks[dead_tuples->num_blocks - 1].blkno < blkno);
+
+	nbitmapwords = offsets[noffsets - 1] / 16 + 1;
+
+	db = &dead_tuples->blocks[dead_tuples->num_blocks];
+	db->blkno = blkno;
+
+	if (nbitmapwords < noffsets)
+	{
+		dead_tuples->used_words += nbitmapwords;
+		words = OFFSET_WORDS(dead_tuples) - dead_tuples->used_words;
+		memset(words, 0, nbitmapwords * sizeof(uint16));
+		for (int i = 0; i < noffsets; i++)
+			words[offsets[i] / 16] |= (uint16) 1 << (offsets[i] % 16);
+		db->end = dead_tuples->used_words | DEADBLOCK_BITMAP;
+	}
+	else
+	{
+		dead_tuples->used_words += noffsets;
+		words = OFFSET_WORDS(dead_tuples) - dead_tuples->used_words;
+		memcpy(words, offsets, noffsets * sizeof(uint16));
+		db->end = dead_tuples->used_words;
+	}
+
+	dead_tuples->num_blocks++;
+	dead_tuples->num_tuples += noffsets;
+
+	Assert(dead_tuples->num_blocks * sizeof(LVDeadBlock) +
+		   dead_tuples->used_words * sizeof(uint16) <= dead_tuples->max_bytes);
+}
+
+/*
+ *	dead_tuples_get_offsets() -- get the dead offsets of a block entry
+ *
+ * The offsets are returned in ascending order in the caller-supplied array,
+ * which must have room for MaxHeapTuplesPerPage entries.  Returns the number
+ * of offsets.
+ */
+static int
+dead_tuples_get_offsets(LVDeadTuples *dead_tuples, int blockindex,
+						OffsetNumber *offsets)
+{
+	LVDeadBlock *db = &dead_tuples->blocks[blockindex];
+	uint32		start = (blockindex == 0) ? 0 : DEADBLOCK_END(db - 1);
+	int			nwords = DEADBLOCK_END(db) - start;
+	uint16	   *words = OFFSET_WORDS(dead_tuples) - DEADBLOCK_END(db);
+	int			noffsets = 0;
+
+	if ((db->end & DEADBLOCK_BITMAP) == 0)
+	{
+		memcpy(offsets, words, nwords * sizeof(uint16));
+		return nwords;
+	}
+
+	for (int i = 0; i < nwords; i++)
+	{
+		uint16		w = words[i];
+
+		while (w != 0)
+		{
+			int			bit = pg_rightmost_one_pos32(w);
+
+			offsets[noffsets++] = i * 16 + bit;
+			w &= w - 1;
+		}
+	}
+
+	return noffsets;
+}
+
 /*
  *	lazy_tid_reaped() -- is a particular tid deletable?
  *
  *		This has the right signature to be an IndexBulkDeleteCallback.
- *
- *		Assumes dead_tuples array is in sorted order.
  */
 static bool
 lazy_tid_reaped(ItemPointer itemptr, void *state)
 {
 	LVDeadTuples *dead_tuples = (LVDeadTuples *) state;
-	int64		litem,
-				ritem,
-				item;
-	ItemPointer res;
-
-	litem = itemptr_encode(&dead_tuples->itemptrs[0]);
-	ritem = itemptr_encode(&dead_tuples->itemptrs[dead_tuples->num_tuples - 1]);
-	item = itemptr_encode(itemptr);
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	OffsetNumber offnum = ItemPointerGetOffsetNumber(itemptr);
+	LVDeadBlock *db;
+	uint16	   *words;
+	uint32		start;
+	int			nwords;
+	int			lo,
+				hi;
+
+	if (dead_tuples->num_blocks == 0)
+		return false;
 
 	/*
-	 * Doing a simple bound check before bsearch() is useful to avoid the
-	 * extra cost of bsearch(), especially if dead tuples on the heap are
-	 * concentrated in a certain range.  Since this function is called for
-	 * every index tuple, it pays to be really fast.
+	 * Doing a simple bound check before the binary search is useful to avoid
+	 * its extra cost, especially if dead tuples on the heap are concentrated
+	 * in a certain range.  Since this function is called for every index
+	 * tuple, it pays to be really fast.
 	 */
-	if (item < litem || item > ritem)
+	if (blkno < dead_tuples->blocks[0].blkno ||
+		blkno > dead_tuples->blocks[dead_tuples->num_blocks - 1].blkno)
 		return false;
 
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) dead_tuples->itemptrs,
-								dead_tuples->num_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
-
-	return (res != NULL);
-}
+	/* Find the block entry */
+	lo = 0;
+	hi = dead_tuples->num_blocks - 1;
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
 
-/*
- * Comparator routines for use with qsort() and bsearch().
- */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
-{
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
+		if (dead_tuples->blocks[mid].blkno < blkno)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	db = &dead_tuples->blocks[lo];
+	if (db->blkno != blkno)
+		return false;
 
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
+	start = (lo == 0) ? 0 : DEADBLOCK_END(db - 1);
+	nwords = DEADBLOCK_END(db) - start;
+	words = OFFSET_WORDS(dead_tuples) - DEADBLOCK_END(db);
 
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
+	if (db->end & DEADBLOCK_BITMAP)
+	{
+		if (offnum / 16 >= nwords)
+			return false;
+		return (words[offnum / 16] & ((uint16) 1 << (offnum % 16))) != 0;
+	}
 
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
+	/* Binary search the sorted offset list */
+	lo = 0;
+	hi = nwords - 1;
+	while (lo <= hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
 
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
+		if (words[mid] == offnum)
+			return true;
+		if (words[mid] < offnum)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
 
-	return 0;
+	return false;
 }
 
 /*
@@ -3849,7 +3985,7 @@ begin_parallel_vacuum(LVRelState *vacrel, BlockNumber nblocks,
 	BufferUsage *buffer_usage;
 	WalUsage   *wal_usage;
 	bool	   *will_parallel_vacuum;
-	long		maxtuples;
+	Size		space;
 	Size		est_shared;
 	Size		est_deadtuples;
 	int			nindexes_mwm = 0;
@@ -3925,8 +4061,8 @@ begin_parallel_vacuum(LVRelState *vacrel, BlockNumber nblocks,
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 
 	/* Estimate size for dead tuples -- PARALLEL_VACUUM_KEY_DEAD_TUPLES */
-	maxtuples = compute_max_dead_tuples(nblocks, true);
-	est_deadtuples = MAXALIGN(SizeOfDeadTuples(maxtuples));
+	space = compute_dead_tuples_space(nblocks, true);
+	est_deadtuples = MAXALIGN(SizeOfDeadTuples(space));
 	shm_toc_estimate_chunk(&pcxt->estimator, est_deadtuples);
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 
@@ -3991,9 +4127,8 @@ begin_parallel_vacuum(LVRelState *vacrel, BlockNumber nblocks,
 
 	/* Prepare the dead tuple space */
 	dead_tuples = (LVDeadTuples *) shm_toc_allocate(pcxt->toc, est_deadtuples);
-	dead_tuples->max_tuples = maxtuples;
-	dead_tuples->num_tuples = 0;
-	MemSet(dead_tuples->itemptrs, 0, sizeof(ItemPointerData) * maxtuples);
+	dead_tuples->max_bytes = space;
+	dead_tuples_reset(dead_tuples);
 	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_DEAD_TUPLES, dead_tuples);
 	vacrel->dead_tuples = dead_tuples;
 
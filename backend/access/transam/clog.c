@@ -88,6 +88,9 @@ static SlruCtlData XactCtlData;
 
 #define XactCtl (&XactCtlData)
 
+/* GUC variable: number of CLOG buffers, or 0 to size from shared_buffers */
+int			transaction_buffers = 0;
+
 
 static int	ZeroCLOGPage(int pageno, bool writeXlog);
 static bool CLOGPagePrecedes(int page1, int page2);
@@ -667,21 +670,18 @@ TransactionIdGetStatus(TransactionId xid, XLogRecPtr *lsn)
  *
  * On larger multi-processor systems, it is possible to have many CLOG page
  * requests in flight at one time which could lead to disk access for CLOG
- * page if the required page is not found in memory.  Testing revealed that we
- * can get the best performance by having 128 CLOG buffers, more than that it
- * doesn't improve performance.
- *
- * Unconditionally keeping the number of CLOG buffers to 128 did not seem like
- * a good idea, because it would increase the minimum amount of shared memory
- * required to start, which could be a problem for people running very small
- * configurations.  The following formula seems to represent a reasonable
- * compromise: people with very low values for shared_buffers will get fewer
- * CLOG buffers as well, and everyone else will get 128.
+ * page if the required page is not found in memory.  transaction_buffers
+ * sets the number explicitly.  If it is zero, people with very low values
+ * for shared_buffers get fewer CLOG buffers as well, and everyone else gets
+ * more, up to 1024; since slru.c searches only one bank of buffers per
+ * lookup, a large pool doesn't slow down lookups.
  */
 Size
 CLOGShmemBuffers(void)
 {
-	return Min(128, Max(4, NBuffers / 512));
+	if (transaction_buffers != 0)
+		return transaction_buffers;
+	return SimpleLruAutotuneBuffers(512, 1024);
 }
 
 /*
@@ -698,7 +698,7 @@ CLOGShmemInit(void)
 {
 	XactCtl->PagePrecedes = CLOGPagePrecedes;
 	SimpleLruInit(XactCtl, "Xact", CLOGShmemBuffers(), CLOG_LSNS_PER_PAGE,
-				  XactSLRULock, "pg_xact", LWTRANCHE_XACT_BUFFER,
+				  XactSLRULock, "pg_xact", LWTRANCHE_XACT_BUFFER, -1,
 				  SYNC_HANDLER_CLOG);
 	SlruPagePrecedesUnitTests(XactCtl, CLOG_XACTS_PER_PAGE);
 }
@@ -763,7 +763,7 @@ StartupCLOG(void)
 	/*
 	 * Initialize our idea of the latest page number.
 	 */
-	XactCtl->shared->latest_page_number = pageno;
+	pg_atomic_write_u32(&XactCtl->shared->latest_page_number, pageno);
 
 	LWLockRelease(XactSLRULock);
 }
@@ -99,8 +99,9 @@ typedef struct CommitTimestampShared
 CommitTimestampShared *commitTsShared;
 
 
-/* GUC variable */
+/* GUC variables */
 bool		track_commit_timestamp;
+int			commit_timestamp_buffers = 0;
 
 static void SetXidCommitTsInPage(TransactionId xid, int nsubxids,
 								 TransactionId *subxids, TimestampTz ts,
@@ -515,7 +516,9 @@ pg_xact_commit_timestamp_origin(PG_FUNCTION_ARGS)
 Size
 CommitTsShmemBuffers(void)
 {
-	return Min(16, Max(4, NBuffers / 1024));
+	if (commit_timestamp_buffers != 0)
+		return commit_timestamp_buffers;
+	return SimpleLruAutotuneBuffers(1024, 1024);
 }
 
 /*
@@ -540,7 +543,7 @@ CommitTsShmemInit(void)
 	CommitTsCtl->PagePrecedes = CommitTsPagePrecedes;
 	SimpleLruInit(CommitTsCtl, "CommitTs", CommitTsShmemBuffers(), 0,
 				  CommitTsSLRULock, "pg_commit_ts",
-				  LWTRANCHE_COMMITTS_BUFFER,
+				  LWTRANCHE_COMMITTS_BUFFER, -1,
 				  SYNC_HANDLER_COMMIT_TS);
 	SlruPagePrecedesUnitTests(CommitTsCtl, COMMIT_TS_XACTS_PER_PAGE);
 
@@ -698,7 +701,7 @@ ActivateCommitTs(void)
 	 * Re-Initialize our idea of the latest page number.
 	 */
 	LWLockAcquire(CommitTsSLRULock, LW_EXCLUSIVE);
-	CommitTsCtl->shared->latest_page_number = pageno;
+	pg_atomic_write_u32(&CommitTsCtl->shared->latest_page_number, pageno);
 	LWLockRelease(CommitTsSLRULock);
 
 	/*
@@ -1014,7 +1017,8 @@ commit_ts_redo(XLogReaderState *record)
 		 * During XLOG replay, latest_page_number isn't set up yet; insert a
 		 * suitable value to bypass the sanity test in SimpleLruTruncate.
 		 */
-		CommitTsCtl->shared->latest_page_number = trunc->pageno;
+		pg_atomic_write_u32(&CommitTsCtl->shared->latest_page_number,
+							trunc->pageno);
 
 		SimpleLruTruncate(CommitTsCtl, trunc->pageno);
 	}
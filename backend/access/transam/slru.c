@@ -7,11 +7,14 @@
  * buffers.  Under ordinary circumstances we expect that write
  * traffic will occur mostly to the latest page (and to the just-prior
  * page, soon after a page transition).  Read traffic will probably touch
- * a larger span of pages, but in any case a fairly small number of page
- * buffers should be sufficient.  So, we just search the buffers using plain
- * linear search; there's no need for a hashtable or anything fancy.
- * The management algorithm is straight LRU except that we will never swap
- * out the latest page (since we know it's going to be hit again eventually).
+ * a larger span of pages.  Workloads with many subtransactions or
+ * multixacts can need a lot of buffers, so the buffers are divided into
+ * banks of about SLRU_BANK_SIZE slots, and each page number maps to exactly
+ * one bank.  Lookups and victim selection search only that bank, using plain
+ * linear search, so their cost doesn't grow with the number of buffers.
+ * The management algorithm is straight LRU within a bank, except that we will
+ * never swap out the latest page (since we know it's going to be hit again
+ * eventually).
  *
  * We use a control LWLock to protect the shared data structures, plus
  * per-buffer LWLocks that synchronize I/O for each buffer.  The control lock
@@ -19,6 +22,15 @@
  * reading in or writing out a page buffer does not hold the control lock,
  * only the per-buffer lock for the buffer it is working on.
  *
+ * An SLRU can instead be set up with one control lock per bank, so that
+ * backends working on pages in different banks don't contend with each
+ * other.  Each bank lock protects the state of the slots in its bank, and
+ * SimpleLruGetBankLock() returns the lock a caller must hold for a given
+ * page.  In an SLRU with a single control lock, that function returns the
+ * control lock for every page, so the rules below apply to both setups with
+ * "control lock" meaning the lock of the bank in question.  A process holds
+ * at most one bank lock at a time.
+ *
  * "Holding the control lock" means exclusive lock in all cases except for
  * SimpleLruReadPage_ReadOnly(); see comments for SlruRecentlyUsed() for
  * the implications of that.
@@ -97,13 +109,14 @@ typedef struct SlruWriteAllData *SlruWriteAll;
  *
  * The reason for the if-test is that there are often many consecutive
  * accesses to the same page (particularly the latest page).  By suppressing
- * useless increments of cur_lru_count, we reduce the probability that old
- * pages' counts will "wrap around" and make them appear recently used.
+ * useless increments of the bank's LRU counter, we reduce the probability
+ * that old pages' counts will "wrap around" and make them appear recently
+ * used.
  *
  * We allow this code to be executed concurrently by multiple processes within
  * SimpleLruReadPage_ReadOnly().  As long as int reads and writes are atomic,
  * this should not cause any completely-bogus values to enter the computation.
- * However, it is possible for either cur_lru_count or individual
+ * However, it is possible for either the bank's counter or individual
  * page_lru_count entries to be "reset" to lower values than they should have,
  * in case a process is delayed while it executes this macro.  With care in
  * SlruSelectLRUPage(), this does little harm, and in any case the absolute
@@ -112,9 +125,11 @@ typedef struct SlruWriteAllData *SlruWriteAll;
  */
 #define SlruRecentlyUsed(shared, slotno)	\
 	do { \
-		int		new_lru_count = (shared)->cur_lru_count; \
+		int	   *cur_lru_count = \
+			&(shared)->bank_cur_lru_count[SlruSlotBank(shared, slotno)]; \
+		int		new_lru_count = *cur_lru_count; \
 		if (new_lru_count != (shared)->page_lru_count[slotno]) { \
-			(shared)->cur_lru_count = ++new_lru_count; \
+			*cur_lru_count = ++new_lru_count; \
 			(shared)->page_lru_count[slotno] = new_lru_count; \
 		} \
 	} while (0)
@@ -142,11 +157,26 @@ static bool SlruPhysicalWritePage(SlruCtl ctl, int pageno, int slotno,
 								  SlruWriteAll fdata);
 static void SlruReportIOError(SlruCtl ctl, int pageno, TransactionId xid);
 static int	SlruSelectLRUPage(SlruCtl ctl, int pageno);
+static inline int SlruPageBank(SlruShared shared, int pageno);
+static inline int SlruSlotBank(SlruShared shared, int slotno);
+static inline int SlruBankStart(SlruShared shared, int bankno);
+static inline int SlruBankEnd(SlruShared shared, int bankno);
+static inline LWLock *SlruBankLock(SlruShared shared, int bankno);
 
 static bool SlruScanDirCbDeleteCutoff(SlruCtl ctl, char *filename,
 									  int segpage, void *data);
 static void SlruInternalDeleteSegment(SlruCtl ctl, int segno);
 
+/*
+ * Helper for the *_buffers GUCs: pick a number of buffers that scales with
+ * shared_buffers, from SLRU_BANK_SIZE up to max.
+ */
+int
+SimpleLruAutotuneBuffers(int divisor, int max)
+{
+	return Min(max, Max(SLRU_BANK_SIZE, NBuffers / divisor));
+}
+
 /*
  * Initialization of shared memory
  */
@@ -154,6 +184,7 @@ static void SlruInternalDeleteSegment(SlruCtl ctl, int segno);
 Size
 SimpleLruShmemSize(int nslots, int nlsns)
 {
+	int			nbanks = Max(1, nslots / SLRU_BANK_SIZE);
 	Size		sz;
 
 	/* we assume nslots isn't so large as to risk overflow */
@@ -164,6 +195,8 @@ SimpleLruShmemSize(int nslots, int nlsns)
 	sz += MAXALIGN(nslots * sizeof(int));	/* page_number[] */
 	sz += MAXALIGN(nslots * sizeof(int));	/* page_lru_count[] */
 	sz += MAXALIGN(nslots * sizeof(LWLockPadded));	/* buffer_locks[] */
+	sz += MAXALIGN(nbanks * sizeof(LWLockPadded));	/* bank_locks[] */
+	sz += MAXALIGN(nbanks * sizeof(int));	/* bank_cur_lru_count[] */
 
 	if (nlsns > 0)
 		sz += MAXALIGN(nslots * nlsns * sizeof(XLogRecPtr));	/* group_lsn[] */
@@ -178,18 +211,23 @@ SimpleLruShmemSize(int nslots, int nlsns)
  * name: name of SLRU.  (This is user-visible, pick with care!)
  * nslots: number of page slots to use.
  * nlsns: number of LSN groups per page (set to zero if not relevant).
- * ctllock: LWLock to use to control access to the shared control structure.
+ * ctllock: LWLock to use to control access to the shared control structure,
+ *		or NULL to give each bank its own lock.
  * subdir: PGDATA-relative subdirectory that will contain the files.
  * tranche_id: LWLock tranche ID to use for the SLRU's per-buffer LWLocks.
+ * bank_tranche_id: LWLock tranche ID to use for the per-bank locks, or -1
+ *		if ctllock is given.
  */
 void
 SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 			  LWLock *ctllock, const char *subdir, int tranche_id,
-			  SyncRequestHandler sync_handler)
+			  int bank_tranche_id, SyncRequestHandler sync_handler)
 {
 	SlruShared	shared;
 	bool		found;
 
+	Assert((ctllock == NULL) != (bank_tranche_id < 0));
+
 	shared = (SlruShared) ShmemInitStruct(name,
 										  SimpleLruShmemSize(nslots, nlsns),
 										  &found);
@@ -200,6 +238,7 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		char	   *ptr;
 		Size		offset;
 		int			slotno;
+		int			bankno;
 
 		Assert(!found);
 
@@ -208,11 +247,11 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		shared->ControlLock = ctllock;
 
 		shared->num_slots = nslots;
+		shared->num_banks = Max(1, nslots / SLRU_BANK_SIZE);
 		shared->lsn_groups_per_page = nlsns;
 
-		shared->cur_lru_count = 0;
-
-		/* shared->latest_page_number will be set later */
+		/* the real latest_page_number will be set later */
+		pg_atomic_init_u32(&shared->latest_page_number, 0);
 
 		shared->slru_stats_idx = pgstat_slru_index(name);
 
@@ -228,10 +267,23 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		offset += MAXALIGN(nslots * sizeof(int));
 		shared->page_lru_count = (int *) (ptr + offset);
 		offset += MAXALIGN(nslots * sizeof(int));
+		shared->bank_cur_lru_count = (int *) (ptr + offset);
+		offset += MAXALIGN(shared->num_banks * sizeof(int));
 
 		/* Initialize LWLocks */
 		shared->buffer_locks = (LWLockPadded *) (ptr + offset);
 		offset += MAXALIGN(nslots * sizeof(LWLockPadded));
+		if (ctllock == NULL)
+		{
+			shared->bank_locks = (LWLockPadded *) (ptr + offset);
+			for (bankno = 0; bankno < shared->num_banks; bankno++)
+				LWLockInitialize(&shared->bank_locks[bankno].lock,
+								 bank_tranche_id);
+		}
+		offset += MAXALIGN(shared->num_banks * sizeof(LWLockPadded));
+
+		for (bankno = 0; bankno < shared->num_banks; bankno++)
+			shared->bank_cur_lru_count[bankno] = 0;
 
 		if (nlsns > 0)
 		{
@@ -267,6 +319,20 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 	strlcpy(ctl->Dir, subdir, sizeof(ctl->Dir));
 }
 
+/*
+ * Return the LWLock that protects the bank the given page maps to.  This is
+ * the lock callers must hold while calling SimpleLruZeroPage(),
+ * SimpleLruReadPage() or SimpleLruWritePage() for the page, and while
+ * examining or modifying the page's buffer.
+ */
+LWLock *
+SimpleLruGetBankLock(SlruCtl ctl, int pageno)
+{
+	SlruShared	shared = ctl->shared;
+
+	return SlruBankLock(shared, SlruPageBank(shared, pageno));
+}
+
 /*
  * Initialize (or reinitialize) a page to zeroes.
  *
@@ -301,7 +367,7 @@ SimpleLruZeroPage(SlruCtl ctl, int pageno)
 	SimpleLruZeroLSNs(ctl, slotno);
 
 	/* Assume this page is now the latest active page */
-	shared->latest_page_number = pageno;
+	pg_atomic_write_u32(&shared->latest_page_number, pageno);
 
 	/* update the stats counter of zeroed pages */
 	pgstat_count_slru_page_zeroed(shared->slru_stats_idx);
@@ -340,12 +406,13 @@ static void
 SimpleLruWaitIO(SlruCtl ctl, int slotno)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SlruBankLock(shared, SlruSlotBank(shared, slotno));
 
 	/* See notes at top of file */
-	LWLockRelease(shared->ControlLock);
+	LWLockRelease(banklock);
 	LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_SHARED);
 	LWLockRelease(&shared->buffer_locks[slotno].lock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	/*
 	 * If the slot is still in an io-in-progress state, then either someone
@@ -395,6 +462,7 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 				  TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SimpleLruGetBankLock(ctl, pageno);
 
 	/* Outer loop handles restart if we must wait for someone else's I/O */
 	for (;;)
@@ -444,7 +512,7 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_EXCLUSIVE);
 
 		/* Release control lock while doing I/O */
-		LWLockRelease(shared->ControlLock);
+		LWLockRelease(banklock);
 
 		/* Do the read */
 		ok = SlruPhysicalReadPage(ctl, pageno, slotno);
@@ -453,7 +521,7 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		SimpleLruZeroLSNs(ctl, slotno);
 
 		/* Re-acquire control lock and update page state */
-		LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+		LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 		Assert(shared->page_number[slotno] == pageno &&
 			   shared->page_status[slotno] == SLRU_PAGE_READ_IN_PROGRESS &&
@@ -494,13 +562,17 @@ int
 SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno = SlruPageBank(shared, pageno);
+	LWLock	   *banklock = SlruBankLock(shared, bankno);
 	int			slotno;
+	int			bankend;
 
 	/* Try to find the page while holding only shared lock */
-	LWLockAcquire(shared->ControlLock, LW_SHARED);
+	LWLockAcquire(banklock, LW_SHARED);
 
-	/* See if page is already in a buffer */
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/* See if page is already in a buffer of its bank */
+	bankend = SlruBankEnd(shared, bankno);
+	for (slotno = SlruBankStart(shared, bankno); slotno < bankend; slotno++)
 	{
 		if (shared->page_number[slotno] == pageno &&
 			shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
@@ -517,8 +589,8 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	}
 
 	/* No luck, so switch to normal exclusive lock and do regular read */
-	LWLockRelease(shared->ControlLock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockRelease(banklock);
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	return SimpleLruReadPage(ctl, pageno, true, xid);
 }
@@ -538,6 +610,7 @@ static void
 SlruInternalWritePage(SlruCtl ctl, int slotno, SlruWriteAll fdata)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SlruBankLock(shared, SlruSlotBank(shared, slotno));
 	int			pageno = shared->page_number[slotno];
 	bool		ok;
 
@@ -568,7 +641,7 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruWriteAll fdata)
 	LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_EXCLUSIVE);
 
 	/* Release control lock while doing I/O */
-	LWLockRelease(shared->ControlLock);
+	LWLockRelease(banklock);
 
 	/* Do the write */
 	ok = SlruPhysicalWritePage(ctl, pageno, slotno, fdata);
@@ -583,7 +656,7 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruWriteAll fdata)
 	}
 
 	/* Re-acquire control lock and update page state */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	Assert(shared->page_number[slotno] == pageno &&
 		   shared->page_status[slotno] == SLRU_PAGE_WRITE_IN_PROGRESS);
@@ -998,6 +1071,52 @@ SlruReportIOError(SlruCtl ctl, int pageno, TransactionId xid)
 	}
 }
 
+/*
+ * Return the bank that the given page can be cached in.
+ */
+static inline int
+SlruPageBank(SlruShared shared, int pageno)
+{
+	return (uint32) pageno % shared->num_banks;
+}
+
+/*
+ * Return the bank that the given buffer slot belongs to; this is the inverse
+ * of SlruBankStart()/SlruBankEnd().
+ */
+static inline int
+SlruSlotBank(SlruShared shared, int slotno)
+{
+	return ((int64) (slotno + 1) * shared->num_banks - 1) / shared->num_slots;
+}
+
+/*
+ * Return the range of buffer slots, [SlruBankStart, SlruBankEnd), of the
+ * given bank.  The slots are divided as evenly as possible between the banks.
+ */
+static inline int
+SlruBankStart(SlruShared shared, int bankno)
+{
+	return bankno * shared->num_slots / shared->num_banks;
+}
+
+static inline int
+SlruBankEnd(SlruShared shared, int bankno)
+{
+	return (bankno + 1) * shared->num_slots / shared->num_banks;
+}
+
+/*
+ * Return the lock protecting the given bank.
+ */
+static inline LWLock *
+SlruBankLock(SlruShared shared, int bankno)
+{
+	if (shared->bank_locks == NULL)
+		return shared->ControlLock;
+	return &shared->bank_locks[bankno].lock;
+}
+
 /*
  * Select the slot to re-use when we need a free slot.
  *
@@ -1015,12 +1134,16 @@ static int
 SlruSelectLRUPage(SlruCtl ctl, int pageno)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno = SlruPageBank(shared, pageno);
+	int			bankstart = SlruBankStart(shared, bankno);
+	int			bankend = SlruBankEnd(shared, bankno);
 
 	/* Outer loop handles restart after I/O */
 	for (;;)
 	{
 		int			slotno;
 		int			cur_count;
+		int			latest_page_number;
 		int			bestvalidslot = 0;	/* keep compiler quiet */
 		int			best_valid_delta = -1;
 		int			best_valid_page_number = 0; /* keep compiler quiet */
@@ -1029,7 +1152,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		int			best_invalid_page_number = 0;	/* keep compiler quiet */
 
 		/* See if page already has a buffer assigned */
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			if (shared->page_number[slotno] == pageno &&
 				shared->page_status[slotno] != SLRU_PAGE_EMPTY)
@@ -1037,16 +1160,16 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		}
 
 		/*
-		 * If we find any EMPTY slot, just select that one. Else choose a
-		 * victim page to replace.  We normally take the least recently used
-		 * valid page, but we will never take the slot containing
-		 * latest_page_number, even if it appears least recently used.  We
-		 * will select a slot that is already I/O busy only if there is no
-		 * other choice: a read-busy slot will not be least recently used once
-		 * the read finishes, and waiting for an I/O on a write-busy slot is
-		 * inferior to just picking some other slot.  Testing shows the slot
-		 * we pick instead will often be clean, allowing us to begin a read at
-		 * once.
+		 * If we find any EMPTY slot in the page's bank, just select that one.
+		 * Else choose a victim page to replace.  We normally take the least
+		 * recently used valid page, but we will never take the slot
+		 * containing latest_page_number, even if it appears least recently
+		 * used.  We will select a slot that is already I/O busy only if there
+		 * is no other choice: a read-busy slot will not be least recently
+		 * used once the read finishes, and waiting for an I/O on a write-busy
+		 * slot is inferior to just picking some other slot.  Testing shows
+		 * the slot we pick instead will often be clean, allowing us to begin
+		 * a read at once.
 		 *
 		 * Normally the page_lru_count values will all be different and so
 		 * there will be a well-defined LRU page.  But since we allow
@@ -1055,16 +1178,17 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		 * acquire the same lru_count values.  In that case we break ties by
 		 * choosing the furthest-back page.
 		 *
-		 * Notice that this next line forcibly advances cur_lru_count to a
-		 * value that is certainly beyond any value that will be in the
-		 * page_lru_count array after the loop finishes.  This ensures that
+		 * Notice that this next line forcibly advances the bank's counter to
+		 * a value that is certainly beyond any value that will be in the
+		 * bank's page_lru_count entries after the loop finishes.  This ensures that
 		 * the next execution of SlruRecentlyUsed will mark the page newly
 		 * used, even if it's for a page that has the current counter value.
 		 * That gets us back on the path to having good data when there are
 		 * multiple pages with the same lru_count.
 		 */
-		cur_count = (shared->cur_lru_count)++;
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		cur_count = (shared->bank_cur_lru_count[bankno])++;
+		latest_page_number = pg_atomic_read_u32(&shared->latest_page_number);
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			int			this_delta;
 			int			this_page_number;
@@ -1085,7 +1209,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 				this_delta = 0;
 			}
 			this_page_number = shared->page_number[slotno];
-			if (this_page_number == shared->latest_page_number)
+			if (this_page_number == latest_page_number)
 				continue;
 			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
 			{
@@ -1156,6 +1280,7 @@ SimpleLruWriteAll(SlruCtl ctl, bool allow_redirtied)
 {
 	SlruShared	shared = ctl->shared;
 	SlruWriteAllData fdata;
+	LWLock	   *prevlock = NULL;
 	int			slotno;
 	int			pageno = 0;
 	int			i;
@@ -1169,10 +1294,19 @@ SimpleLruWriteAll(SlruCtl ctl, bool allow_redirtied)
 	 */
 	fdata.num_files = 0;
 
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
 	for (slotno = 0; slotno < shared->num_slots; slotno++)
 	{
+		LWLock	   *curlock = SlruBankLock(shared, SlruSlotBank(shared, slotno));
+
+		/* The slots of a bank are adjacent, so switch locks at its start */
+		if (curlock != prevlock)
+		{
+			if (prevlock != NULL)
+				LWLockRelease(prevlock);
+			LWLockAcquire(curlock, LW_EXCLUSIVE);
+			prevlock = curlock;
+		}
+
 		SlruInternalWritePage(ctl, slotno, &fdata);
 
 		/*
@@ -1186,7 +1320,8 @@ SimpleLruWriteAll(SlruCtl ctl, bool allow_redirtied)
 				!shared->page_dirty[slotno]));
 	}
 
-	LWLockRelease(shared->ControlLock);
+	if (prevlock != NULL)
+		LWLockRelease(prevlock);
 
 	/*
 	 * Now close any files that were open
@@ -1225,70 +1360,79 @@ void
 SimpleLruTruncate(SlruCtl ctl, int cutoffPage)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno;
 	int			slotno;
 
 	/* update the stats counter of truncates */
 	pgstat_count_slru_truncate(shared->slru_stats_idx);
 
 	/*
-	 * Scan shared memory and remove any pages preceding the cutoff page, to
-	 * ensure we won't rewrite them later.  (Since this is normally called in
-	 * or just after a checkpoint, any dirty pages should have been flushed
-	 * already ... we're just being extra careful here.)
-	 */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
-restart:;
-
-	/*
-	 * While we are holding the lock, make an important safety check: the
-	 * current endpoint page must not be eligible for removal.
+	 * Make an important safety check: the current endpoint page must not be
+	 * eligible for removal.  This is only a backstop against wraparound bugs
+	 * elsewhere, and the callers' mutual exclusion keeps the endpoint from
+	 * moving much, so we read it without taking any bank lock.
 	 */
-	if (ctl->PagePrecedes(shared->latest_page_number, cutoffPage))
+	if (ctl->PagePrecedes(pg_atomic_read_u32(&shared->latest_page_number),
+						  cutoffPage))
 	{
-		LWLockRelease(shared->ControlLock);
 		ereport(LOG,
 				(errmsg("could not truncate directory \"%s\": apparent wraparound",
 						ctl->Dir)));
 		return;
 	}
 
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/*
+	 * Scan shared memory and remove any pages preceding the cutoff page, to
+	 * ensure we won't rewrite them later.  (Since this is normally called in
+	 * or just after a checkpoint, any dirty pages should have been flushed
+	 * already ... we're just being extra careful here.)  We visit one bank
+	 * at a time, holding its lock.
+	 */
+	for (bankno = 0; bankno < shared->num_banks; bankno++)
 	{
-		if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
-			continue;
-		if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
-			continue;
+		LWLock	   *banklock = SlruBankLock(shared, bankno);
+		int			bankend = SlruBankEnd(shared, bankno);
 
-		/*
-		 * If page is clean, just change state to EMPTY (expected case).
-		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
-			!shared->page_dirty[slotno])
+		LWLockAcquire(banklock, LW_EXCLUSIVE);
+
+restart:
+		for (slotno = SlruBankStart(shared, bankno); slotno < bankend; slotno++)
 		{
-			shared->page_status[slotno] = SLRU_PAGE_EMPTY;
-			continue;
+			if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
+				continue;
+			if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
+				continue;
+
+			/*
+			 * If page is clean, just change state to EMPTY (expected case).
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
+				!shared->page_dirty[slotno])
+			{
+				shared->page_status[slotno] = SLRU_PAGE_EMPTY;
+				continue;
+			}
+
+			/*
+			 * Hmm, we have (or may have) I/O operations acting on the page,
+			 * so we've got to wait for them to finish and then start the
+			 * bank again.  This is the same logic as in SlruSelectLRUPage.
+			 * (XXX if page is dirty, wouldn't it be OK to just discard it
+			 * without writing it?  SlruMayDeleteSegment() uses a stricter
+			 * qualification, so we might not delete this page in the end;
+			 * even if we don't delete it, we won't have cause to read its
+			 * data again.  For now, keep the logic the same as it was.)
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
+				SlruInternalWritePage(ctl, slotno, NULL);
+			else
+				SimpleLruWaitIO(ctl, slotno);
+			goto restart;
 		}
 
-		/*
-		 * Hmm, we have (or may have) I/O operations acting on the page, so
-		 * we've got to wait for them to finish and then start again. This is
-		 * the same logic as in SlruSelectLRUPage.  (XXX if page is dirty,
-		 * wouldn't it be OK to just discard it without writing it?
-		 * SlruMayDeleteSegment() uses a stricter qualification, so we might
-		 * not delete this page in the end; even if we don't delete it, we
-		 * won't have cause to read its data again.  For now, keep the logic
-		 * the same as it was.)
-		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID)
-			SlruInternalWritePage(ctl, slotno, NULL);
-		else
-			SimpleLruWaitIO(ctl, slotno);
-		goto restart;
+		LWLockRelease(banklock);
 	}
 
-	LWLockRelease(shared->ControlLock);
-
 	/* Now we can remove the old segment(s) */
 	(void) SlruScanDirectory(ctl, SlruScanDirCbDeleteCutoff, &cutoffPage);
 }
@@ -1326,51 +1470,63 @@ void
 SlruDeleteSegment(SlruCtl ctl, int segno)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno;
 	int			slotno;
 	bool		did_write;
 
 	/* Clean out any possibly existing references to the segment. */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-restart:
-	did_write = false;
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	for (bankno = 0; bankno < shared->num_banks; bankno++)
 	{
-		int			pagesegno = shared->page_number[slotno] / SLRU_PAGES_PER_SEGMENT;
+		LWLock	   *banklock = SlruBankLock(shared, bankno);
+		int			bankend = SlruBankEnd(shared, bankno);
 
-		if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
-			continue;
+		LWLockAcquire(banklock, LW_EXCLUSIVE);
+restart:
+		did_write = false;
+		for (slotno = SlruBankStart(shared, bankno); slotno < bankend; slotno++)
+		{
+			int			pagesegno = shared->page_number[slotno] / SLRU_PAGES_PER_SEGMENT;
 
-		/* not the segment we're looking for */
-		if (pagesegno != segno)
-			continue;
+			if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
+				continue;
 
-		/* If page is clean, just change state to EMPTY (expected case). */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
-			!shared->page_dirty[slotno])
-		{
-			shared->page_status[slotno] = SLRU_PAGE_EMPTY;
-			continue;
+			/* not the segment we're looking for */
+			if (pagesegno != segno)
+				continue;
+
+			/* If page is clean, just change state to EMPTY (expected case). */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
+				!shared->page_dirty[slotno])
+			{
+				shared->page_status[slotno] = SLRU_PAGE_EMPTY;
+				continue;
+			}
+
+			/* Same logic as SimpleLruTruncate() */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
+				SlruInternalWritePage(ctl, slotno, NULL);
+			else
+				SimpleLruWaitIO(ctl, slotno);
+
+			did_write = true;
 		}
 
-		/* Same logic as SimpleLruTruncate() */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID)
-			SlruInternalWritePage(ctl, slotno, NULL);
-		else
-			SimpleLruWaitIO(ctl, slotno);
+		/*
+		 * Be extra careful and re-check. The IO functions release the bank
+		 * lock, so new pages could have been read in.
+		 */
+		if (did_write)
+			goto restart;
 
-		did_write = true;
+		LWLockRelease(banklock);
 	}
 
 	/*
-	 * Be extra careful and re-check. The IO functions release the control
-	 * lock, so new pages could have been read in.
+	 * Callers prevent the segment's pages from being read in again (see
+	 * SimpleLruTruncate()), so it can be unlinked after the banks' locks have
+	 * been released.
 	 */
-	if (did_write)
-		goto restart;
-
 	SlruInternalDeleteSegment(ctl, segno);
-
-	LWLockRelease(shared->ControlLock);
 }
 
 /*
@@ -0,0 +1,530 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.c
+ *		Prefetching support for recovery.
+ *
+ * Replaying a WAL record that modifies a block that isn't in shared buffers
+ * has to read the block from disk first, and since the startup process
+ * replays one record at a time, recovery speed on a system whose working set
+ * doesn't fit in memory is bounded by single-threaded random read latency.
+ *
+ * To improve on that, the startup process uses a second xlogreader to decode
+ * records a little ahead of the one being replayed, and calls
+ * PrefetchSharedBuffer() for the blocks they reference, so that the kernel
+ * can read them in the background.  How far ahead we look is limited by
+ * recovery_prefetch_distance (in bytes of WAL), and the number of prefetches
+ * we allow to be in flight at once by maintenance_io_concurrency.  A
+ * prefetch is considered to be in flight until replay reaches the record
+ * that caused it.
+ *
+ * We don't prefetch blocks that replay won't read: blocks that will be
+ * restored from a full-page image, or that will be initialized from scratch.
+ * Nor do we try to prefetch blocks of relations that don't exist yet, or
+ * blocks beyond the current end of a relation.  To avoid repeatedly probing
+ * for those, we remember relations (or whole databases) that are being
+ * created, truncated or extended by records we've decoded but that haven't
+ * been replayed yet, and skip them until replay has caught up.
+ *
+ * The read-ahead reader only reads WAL that is already in pg_wal, and never
+ * waits for more to arrive.  When it runs out of WAL, or finds a record it
+ * can't decode, it simply stops until replay has reached the same point,
+ * and then starts over from the record being replayed.  Since prefetching
+ * is only a hint, getting things wrong here can cost some wasted I/O but
+ * never affects correctness.
+ *
+ * Portions Copyright (c) 1996-2021, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/backend/access/transam/xlogprefetch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogprefetch.h"
+#include "access/xlogreader.h"
+#include "access/xlogutils.h"
+#include "catalog/storage_xlog.h"
+#include "commands/dbcommands_xlog.h"
+#include "lib/ilist.h"
+#include "pgstat.h"
+#include "replication/walreceiver.h"
+#include "storage/bufmgr.h"
+#include "storage/fd.h"
+#include "storage/smgr.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+
+/* GUC variables */
+bool		recovery_prefetch = false;
+int			recovery_prefetch_distance = 512 * 1024;
+
+/*
+ * A relation, or with relNode = InvalidOid a whole database, whose blocks
+ * from filter_from_block onwards we shouldn't try to prefetch until replay
+ * has passed filter_until_replayed.
+ */
+typedef struct XLogPrefetcherFilter
+{
+	RelFileNode rnode;			/* hash key; must be first */
+	XLogRecPtr	filter_until_replayed;
+	BlockNumber filter_from_block;
+	dlist_node	link;
+} XLogPrefetcherFilter;
+
+struct XLogPrefetcher
+{
+	/* Reader we use to look ahead, and the timeline it reads */
+	XLogReaderState *reader;
+	TimeLineID	tli;
+
+	/* Don't read WAL beyond this point, if valid */
+	XLogRecPtr	read_limit;
+
+	/*
+	 * If we ran out of WAL to read, or couldn't decode a record, we wait
+	 * until replay reaches this point before starting over.
+	 */
+	bool		stalled;
+	XLogRecPtr	stalled_until;
+
+	/* Is a decoded record pending, and which block do we look at next? */
+	bool		have_record;
+	int			next_block_id;
+
+	/* Relations and databases we're currently not prefetching */
+	HTAB	   *filter_table;
+	dlist_head	filter_queue;
+
+	/*
+	 * Circular queue of the LSNs of records for which we initiated I/O,
+	 * oldest first.  Its length is the number of prefetches in flight.
+	 */
+	XLogRecPtr	inflight_lsns[MAX_IO_CONCURRENCY];
+	int			inflight_head;
+	int			inflight_count;
+
+	/* Statistics, reported at the end of recovery */
+	uint64		prefetch;		/* I/Os initiated */
+	uint64		skip_hit;		/* blocks already in shared buffers */
+	uint64		skip_new;		/* blocks of new or extended relations */
+	uint64		skip_fpw;		/* blocks restored from full-page images */
+};
+
+static int	XLogPrefetcherPageRead(XLogReaderState *reader,
+								   XLogRecPtr targetPagePtr, int reqLen,
+								   XLogRecPtr targetRecPtr, char *readBuf);
+static void XLogPrefetcherReset(XLogPrefetcher *prefetcher,
+								XLogRecPtr restart_lsn);
+static void XLogPrefetcherAddFilter(XLogPrefetcher *prefetcher,
+									RelFileNode rnode, BlockNumber blockno,
+									XLogRecPtr lsn);
+static bool XLogPrefetcherIsFiltered(XLogPrefetcher *prefetcher,
+									 RelFileNode rnode, BlockNumber blockno);
+static void XLogPrefetcherExamineRecord(XLogPrefetcher *prefetcher);
+static bool XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher);
+
+/*
+ * Create a prefetcher for use by the startup process during redo.
+ */
+XLogPrefetcher *
+XLogPrefetcherAllocate(void)
+{
+	XLogPrefetcher *prefetcher;
+	HASHCTL		hash_ctl;
+
+	prefetcher = palloc0(sizeof(XLogPrefetcher));
+	prefetcher->reader =
+		XLogReaderAllocate(wal_segment_size, NULL,
+						   XL_ROUTINE(.page_read = XLogPrefetcherPageRead,
+									  .segment_open = NULL,
+									  .segment_close = wal_segment_close),
+						   prefetcher);
+	if (prefetcher->reader == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+
+	hash_ctl.keysize = sizeof(RelFileNode);
+	hash_ctl.entrysize = sizeof(XLogPrefetcherFilter);
+	prefetcher->filter_table = hash_create("XLogPrefetcherFilterTable", 1024,
+										   &hash_ctl, HASH_ELEM | HASH_BLOBS);
+	dlist_init(&prefetcher->filter_queue);
+
+	/* Nothing to do until we've been told where replay is */
+	prefetcher->stalled = true;
+	prefetcher->stalled_until = InvalidXLogRecPtr;
+
+	return prefetcher;
+}
+
+/*
+ * Destroy a prefetcher, and report what it did.
+ */
+void
+XLogPrefetcherFree(XLogPrefetcher *prefetcher)
+{
+	ereport(DEBUG1,
+			(errmsg_internal("recovery prefetch: " UINT64_FORMAT " prefetched, " UINT64_FORMAT " in buffers, " UINT64_FORMAT " new, " UINT64_FORMAT " full-page images",
+							 prefetcher->prefetch,
+							 prefetcher->skip_hit,
+							 prefetcher->skip_new,
+							 prefetcher->skip_fpw)));
+
+	XLogReaderFree(prefetcher->reader);
+	hash_destroy(prefetcher->filter_table);
+	pfree(prefetcher);
+}
+
+/*
+ * XLogReaderRoutine->page_read callback for the read-ahead reader.
+ *
+ * Read a page from a segment file in pg_wal.  Unlike the callback used for
+ * replay, this never waits and never fetches WAL from elsewhere; it simply
+ * reports failure if the data isn't there.
+ */
+static int
+XLogPrefetcherPageRead(XLogReaderState *reader, XLogRecPtr targetPagePtr,
+					   int reqLen, XLogRecPtr targetRecPtr, char *readBuf)
+{
+	XLogPrefetcher *prefetcher = (XLogPrefetcher *) reader->private_data;
+	XLogSegNo	segno;
+	uint32		offset;
+	int			count = XLOG_BLCKSZ;
+	int			r;
+
+	/* Don't read WAL that the WAL receiver hasn't flushed yet */
+	if (!XLogRecPtrIsInvalid(prefetcher->read_limit))
+	{
+		if (targetPagePtr + reqLen > prefetcher->read_limit)
+			return -1;
+		if (targetPagePtr + XLOG_BLCKSZ > prefetcher->read_limit)
+			count = prefetcher->read_limit - targetPagePtr;
+	}
+
+	XLByteToSeg(targetPagePtr, segno, wal_segment_size);
+	offset = XLogSegmentOffset(targetPagePtr, wal_segment_size);
+
+	/* Switch segment files, if needed */
+	if (reader->seg.ws_file >= 0 &&
+		(reader->seg.ws_segno != segno || reader->seg.ws_tli != prefetcher->tli))
+		wal_segment_close(reader);
+	if (reader->seg.ws_file < 0)
+	{
+		char		path[MAXPGPATH];
+
+		XLogFilePath(path, prefetcher->tli, segno, wal_segment_size);
+		reader->seg.ws_file = BasicOpenFile(path, O_RDONLY | PG_BINARY);
+		if (reader->seg.ws_file < 0)
+			return -1;
+		reader->seg.ws_segno = segno;
+		reader->seg.ws_tli = prefetcher->tli;
+	}
+
+	pgstat_report_wait_start(WAIT_EVENT_WAL_READ);
+	r = pg_pread(reader->seg.ws_file, readBuf, XLOG_BLCKSZ, (off_t) offset);
+	pgstat_report_wait_end();
+
+	if (r != XLOG_BLCKSZ)
+		return -1;
+
+	return count;
+}
+
+/*
+ * Forget everything we know and start reading again at restart_lsn, which
+ * must be the start of a record.
+ */
+static void
+XLogPrefetcherReset(XLogPrefetcher *prefetcher, XLogRecPtr restart_lsn)
+{
+	XLogBeginRead(prefetcher->reader, restart_lsn);
+	prefetcher->stalled = false;
+	prefetcher->have_record = false;
+	prefetcher->next_block_id = 0;
+}
+
+/*
+ * Don't prefetch any blocks >= blockno of rnode, until replay has passed lsn.
+ */
+static void
+XLogPrefetcherAddFilter(XLogPrefetcher *prefetcher, RelFileNode rnode,
+						BlockNumber blockno, XLogRecPtr lsn)
+{
+	XLogPrefetcherFilter *filter;
+	bool		found;
+
+	filter = hash_search(prefetcher->filter_table, &rnode, HASH_ENTER, &found);
+	if (!found)
+	{
+		filter->filter_from_block = blockno;
+		filter->filter_until_replayed = lsn;
+		dlist_push_tail(&prefetcher->filter_queue, &filter->link);
+	}
+	else
+	{
+		/* LSNs only move forward, so keep the queue in order */
+		filter->filter_from_block = Min(filter->filter_from_block, blockno);
+		filter->filter_until_replayed = lsn;
+		dlist_delete(&filter->link);
+		dlist_push_tail(&prefetcher->filter_queue, &filter->link);
+	}
+}
+
+/*
+ * Should we skip prefetching this block, because its relation or database
+ * is being created, truncated or extended by a record not yet replayed?
+ */
+static bool
+XLogPrefetcherIsFiltered(XLogPrefetcher *prefetcher, RelFileNode rnode,
+						 BlockNumber blockno)
+{
+	XLogPrefetcherFilter *filter;
+
+	if (dlist_is_empty(&prefetcher->filter_queue))
+		return false;
+
+	filter = hash_search(prefetcher->filter_table, &rnode, HASH_FIND, NULL);
+	if (filter && filter->filter_from_block <= blockno)
+		return true;
+
+	/* Check for a filter covering the whole database */
+	rnode.relNode = InvalidOid;
+	filter = hash_search(prefetcher->filter_table, &rnode, HASH_FIND, NULL);
+	if (filter)
+		return true;
+
+	return false;
+}
+
+/*
+ * Look at a freshly decoded record for changes that affect which relations
+ * exist, and how big they are.
+ */
+static void
+XLogPrefetcherExamineRecord(XLogPrefetcher *prefetcher)
+{
+	XLogReaderState *reader = prefetcher->reader;
+	uint8		rmid = XLogRecGetRmid(reader);
+	uint8		info = XLogRecGetInfo(reader) & ~XLR_INFO_MASK;
+
+	if (rmid == RM_SMGR_ID && info == XLOG_SMGR_CREATE)
+	{
+		xl_smgr_create *xlrec = (xl_smgr_create *) XLogRecGetData(reader);
+
+		/* The files might not exist until replay creates them */
+		XLogPrefetcherAddFilter(prefetcher, xlrec->rnode, 0,
+								reader->ReadRecPtr);
+	}
+	else if (rmid == RM_SMGR_ID && info == XLOG_SMGR_TRUNCATE)
+	{
+		xl_smgr_truncate *xlrec = (xl_smgr_truncate *) XLogRecGetData(reader);
+
+		/* Blocks past the truncation point will be zapped */
+		XLogPrefetcherAddFilter(prefetcher, xlrec->rnode, xlrec->blkno,
+								reader->ReadRecPtr);
+	}
+	else if (rmid == RM_DBASE_ID && info == XLOG_DBASE_CREATE)
+	{
+		xl_dbase_create_rec *xlrec = (xl_dbase_create_rec *) XLogRecGetData(reader);
+		RelFileNode rnode;
+
+		/* The whole database directory will appear when this is replayed */
+		rnode.spcNode = xlrec->tablespace_id;
+		rnode.dbNode = xlrec->db_id;
+		rnode.relNode = InvalidOid;
+		XLogPrefetcherAddFilter(prefetcher, rnode, 0, reader->ReadRecPtr);
+	}
+}
+
+/*
+ * Issue prefetches for the blocks of the current record, starting at
+ * next_block_id.  Returns false if we had to stop because too many I/Os are
+ * in flight, in which case we'll resume with the same record later.
+ */
+static bool
+XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher)
+{
+	XLogReaderState *reader = prefetcher->reader;
+	int			max_inflight = Min(maintenance_io_concurrency,
+								   MAX_IO_CONCURRENCY);
+
+	for (; prefetcher->next_block_id <= reader->max_block_id;
+		 prefetcher->next_block_id++)
+	{
+		int			block_id = prefetcher->next_block_id;
+		DecodedBkpBlock *block = &reader->blocks[block_id];
+		SMgrRelation reln;
+		PrefetchBufferResult result;
+
+		if (!block->in_use)
+			continue;
+
+		if (prefetcher->inflight_count >= max_inflight)
+			return false;
+
+		/* Replay won't need to read blocks that it overwrites anyway */
+		if (block->has_image && block->apply_image)
+		{
+			prefetcher->skip_fpw++;
+			continue;
+		}
+		if (block->flags & BKPBLOCK_WILL_INIT)
+		{
+			prefetcher->skip_new++;
+			continue;
+		}
+
+		if (XLogPrefetcherIsFiltered(prefetcher, block->rnode, block->blkno))
+		{
+			prefetcher->skip_new++;
+			continue;
+		}
+
+		/*
+		 * If the relation doesn't exist yet, or the block is past its end,
+		 * then this or a later record will create it; skip until then.
+		 */
+		reln = smgropen(block->rnode, InvalidBackendId);
+		if (!smgrexists(reln, block->forknum))
+		{
+			XLogPrefetcherAddFilter(prefetcher, block->rnode, 0,
+									reader->ReadRecPtr);
+			prefetcher->skip_new++;
+			continue;
+		}
+		if (block->blkno >= smgrnblocks(reln, block->forknum))
+		{
+			XLogPrefetcherAddFilter(prefetcher, block->rnode, block->blkno,
+									reader->ReadRecPtr);
+			prefetcher->skip_new++;
+			continue;
+		}
+
+		result = PrefetchSharedBuffer(reln, block->forknum, block->blkno);
+		if (result.initiated_io)
+		{
+			int			slot;
+
+			slot = (prefetcher->inflight_head + prefetcher->inflight_count) %
+				MAX_IO_CONCURRENCY;
+			prefetcher->inflight_lsns[slot] = reader->ReadRecPtr;
+			prefetcher->inflight_count++;
+			prefetcher->prefetch++;
+		}
+		else
+			prefetcher->skip_hit++;
+	}
+
+	return true;
+}
+
+/*
+ * Called by the startup process before replaying the record starting at
+ * replaying_lsn on timeline tli, to issue prefetches for records up to
+ * recovery_prefetch_distance bytes ahead.
+ */
+void
+XLogPrefetcherReadAhead(XLogPrefetcher *prefetcher, XLogRecPtr replaying_lsn,
+						TimeLineID tli)
+{
+	XLogReaderState *reader = prefetcher->reader;
+
+	/* Replay has reached these records, so their I/O is done or moot. */
+	while (prefetcher->inflight_count > 0 &&
+		   prefetcher->inflight_lsns[prefetcher->inflight_head] <= replaying_lsn)
+	{
+		prefetcher->inflight_head =
+			(prefetcher->inflight_head + 1) % MAX_IO_CONCURRENCY;
+		prefetcher->inflight_count--;
+	}
+
+	/* Likewise, drop filters for records that replay has reached. */
+	while (!dlist_is_empty(&prefetcher->filter_queue))
+	{
+		XLogPrefetcherFilter *filter;
+
+		filter = dlist_head_element(XLogPrefetcherFilter, link,
+									&prefetcher->filter_queue);
+		if (filter->filter_until_replayed >= replaying_lsn)
+			break;
+		dlist_delete(&filter->link);
+		hash_search(prefetcher->filter_table, &filter->rnode, HASH_REMOVE,
+					NULL);
+	}
+
+	if (!recovery_prefetch || maintenance_io_concurrency <= 0)
+	{
+		/* Start over from the right place if we're re-enabled */
+		prefetcher->stalled = true;
+		prefetcher->stalled_until = InvalidXLogRecPtr;
+		return;
+	}
+
+	/*
+	 * If the timeline has changed, or we've fallen behind replay, start over
+	 * from the record being replayed.
+	 */
+	if (!prefetcher->stalled &&
+		(prefetcher->tli != tli ||
+		 (prefetcher->have_record ? reader->ReadRecPtr : reader->EndRecPtr) < replaying_lsn))
+	{
+		prefetcher->stalled = true;
+		prefetcher->stalled_until = InvalidXLogRecPtr;
+	}
+	if (prefetcher->stalled)
+	{
+		if (replaying_lsn < prefetcher->stalled_until)
+			return;
+		prefetcher->tli = tli;
+		XLogPrefetcherReset(prefetcher, replaying_lsn);
+	}
+
+	prefetcher->read_limit = GetWalRcvFlushRecPtr(NULL, NULL);
+
+	for (;;)
+	{
+		if (!prefetcher->have_record)
+		{
+			XLogRecord *record;
+			XLogRecPtr	next_lsn = reader->EndRecPtr;
+			char	   *errormsg;
+
+			/* Don't look further ahead than we've been asked to */
+			if (next_lsn >= replaying_lsn + recovery_prefetch_distance)
+				break;
+
+			record = XLogReadRecord(reader, &errormsg);
+			if (record == NULL)
+			{
+				/* Try again once replay gets here */
+				prefetcher->stalled = true;
+				prefetcher->stalled_until = Max(next_lsn, replaying_lsn + 1);
+				break;
+			}
+
+			prefetcher->have_record = true;
+			prefetcher->next_block_id = 0;
+
+			/* Replay is already taking care of this one */
+			if (reader->ReadRecPtr <= replaying_lsn)
+			{
+				prefetcher->have_record = false;
+				continue;
+			}
+
+			XLogPrefetcherExamineRecord(prefetcher);
+		}
+
+		if (!XLogPrefetcherScanBlocks(prefetcher))
+			break;				/* too much I/O in flight */
+
+		prefetcher->have_record = false;
+	}
+}
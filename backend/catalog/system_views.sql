@@ -879,6 +879,16 @@ CREATE VIEW pg_stat_slru AS
             s.stats_reset
     FROM pg_stat_get_slru() s;
 
+CREATE VIEW pg_stat_lwlock AS
+    SELECT
+            s.name,
+            s.acquisitions,
+            s.waits,
+            s.spins,
+            s.wait_time,
+            s.stats_reset
+    FROM pg_stat_get_lwlock() s;
+
 CREATE VIEW pg_stat_wal_receiver AS
     SELECT
             s.pid,
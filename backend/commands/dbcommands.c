@@ -57,6 +57,7 @@
 #include "storage/lmgr.h"
 #include "storage/md.h"
 #include "storage/procarray.h"
+#include "storage/relsize.h"
 #include "storage/smgr.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
@@ -970,6 +971,9 @@ dropdb(const char *dbname, bool missing_ok, bool force)
 	 */
 	DropDatabaseBuffers(db_id);
 
+	/* Likewise forget any cached relation sizes */
+	RelSizeCacheForgetDatabase(db_id);
+
 	/*
 	 * Tell the stats collector to forget it immediately, too.
 	 */
@@ -1255,6 +1259,7 @@ movedb(const char *dbname, const char *tblspcname)
 	 * src_tblspcoid, but bufmgr.c presently provides no API for that.
 	 */
 	DropDatabaseBuffers(db_id);
+	RelSizeCacheForgetDatabase(db_id);
 
 	/*
 	 * Check for existence of files in the target directory, i.e., objects of
@@ -2204,6 +2209,9 @@ dbase_redo(XLogReaderState *record)
 								dst_path)));
 		}
 
+		/* Sizes cached for the old directory's files are stale now */
+		RelSizeCacheForgetDatabase(xlrec->db_id);
+
 		/*
 		 * Force dirty buffers out to disk, to ensure source database is
 		 * up-to-date for the copy.
@@ -2244,6 +2252,7 @@ dbase_redo(XLogReaderState *record)
 
 		/* Drop pages for this database that are in the shared buffer cache */
 		DropDatabaseBuffers(xlrec->db_id);
+		RelSizeCacheForgetDatabase(xlrec->db_id);
 
 		/* Also, clean out any fsync requests that might be pending in md.c */
 		ForgetDatabaseSyncRequests(xlrec->db_id);
@@ -28,6 +28,10 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #endif
+/* same condition as PQ_HAVE_SENDFILE in libpq/libpq.h */
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
 
 #include "libpq/libpq.h"
 #include "miscadmin.h"
@@ -328,6 +332,72 @@ retry:
 	return n;
 }
 
+#ifdef PQ_HAVE_SENDFILE
+/*
+ *	Send len bytes of the file fd, starting at offset, to the client with
+ *	sendfile().  Only usable on connections that are neither SSL nor GSSAPI
+ *	encrypted, as the data bypasses the encryption layer.  Waits and handles
+ *	interrupts the same way as secure_write().
+ */
+ssize_t
+secure_sendfile(Port *port, int fd, off_t offset, size_t len)
+{
+	ssize_t		n;
+
+#ifdef USE_SSL
+	Assert(!port->ssl_in_use);
+#endif
+#ifdef ENABLE_GSS
+	Assert(!(port->gss && port->gss->enc));
+#endif
+
+	/* Deal with any already-pending interrupt condition. */
+	ProcessClientWriteInterrupt(false);
+
+retry:
+	n = sendfile(port->sock, fd, &offset, len);
+
+	if (n < 0 && !port->noblock && (errno == EWOULDBLOCK || errno == EAGAIN))
+	{
+		WaitEvent	event;
+
+		ModifyWaitEvent(FeBeWaitSet, FeBeWaitSetSocketPos,
+						WL_SOCKET_WRITEABLE, NULL);
+
+		WaitEventSetWait(FeBeWaitSet, -1 /* no timeout */ , &event, 1,
+						 WAIT_EVENT_CLIENT_WRITE);
+
+		/* See comments in secure_read. */
+		if (event.events & WL_POSTMASTER_DEATH)
+			ereport(FATAL,
+					(errcode(ERRCODE_ADMIN_SHUTDOWN),
+					 errmsg("terminating connection due to unexpected postmaster exit")));
+
+		/* Handle interrupt. */
+		if (event.events & WL_LATCH_SET)
+		{
+			ResetLatch(MyLatch);
+			ProcessClientWriteInterrupt(true);
+		}
+		goto retry;
+	}
+
+	/*
+	 * A zero return means the file ended before len bytes were sent; it's
+	 * not supposed to be shorter than that, so treat it as an I/O error.
+	 */
+	if (n == 0 && len > 0)
+	{
+		errno = EIO;
+		n = -1;
+	}
+
+	ProcessClientWriteInterrupt(false);
+
+	return n;
+}
+#endif							/* PQ_HAVE_SENDFILE */
+
 ssize_t
 secure_raw_write(Port *port, const void *ptr, size_t len)
 {
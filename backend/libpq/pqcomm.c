@@ -126,6 +126,15 @@ static int	PqSendBufferSize;	/* Size send buffer */
 static int	PqSendPointer;		/* Next index to store a byte in PqSendBuffer */
 static int	PqSendStart;		/* Next index to send a byte in PqSendBuffer */
 
+/*
+ * A file chunk queued by pq_putmessage_file_noblock(), to be sent after the
+ * buffered data before PqSendFileAt, and before the data after it.
+ */
+static int	PqSendFileFd = -1;	/* file to send from, or -1 if none */
+static off_t PqSendFileOffset;	/* next offset to send from in the file */
+static size_t PqSendFileLen;	/* bytes of the file still to send */
+static int	PqSendFileAt;		/* index in PqSendBuffer the file data goes */
+
 static char PqRecvBuffer[PQ_RECV_BUFFER_SIZE];
 static int	PqRecvPointer;		/* Next index to read a byte from PqRecvBuffer */
 static int	PqRecvLength;		/* End of data available in PqRecvBuffer */
@@ -148,6 +157,7 @@ static int	socket_putmessage(char msgtype, const char *s, size_t len);
 static void socket_putmessage_noblock(char msgtype, const char *s, size_t len);
 static int	internal_putbytes(const char *s, size_t len);
 static int	internal_flush(void);
+static void internal_dropfile(void);
 
 #ifdef HAVE_UNIX_SOCKETS
 static int	Lock_AF_UNIX(const char *unixSocketDir, const char *unixSocketPath);
@@ -1354,14 +1364,27 @@ internal_flush(void)
 {
 	static int	last_reported_send_errno = 0;
 
-	char	   *bufptr = PqSendBuffer + PqSendStart;
-	char	   *bufend = PqSendBuffer + PqSendPointer;
-
-	while (bufptr < bufend)
+	for (;;)
 	{
-		int			r;
+		char	   *bufptr = PqSendBuffer + PqSendStart;
+		char	   *bufend;
+		ssize_t		r;
 
-		r = secure_write(MyProcPort, bufptr, bufend - bufptr);
+		/* buffered data queued ahead of a pending file chunk goes first */
+		if (PqSendFileFd >= 0)
+			bufend = PqSendBuffer + PqSendFileAt;
+		else
+			bufend = PqSendBuffer + PqSendPointer;
+
+		if (bufptr < bufend)
+			r = secure_write(MyProcPort, bufptr, bufend - bufptr);
+#ifdef PQ_HAVE_SENDFILE
+		else if (PqSendFileFd >= 0)
+			r = secure_sendfile(MyProcPort, PqSendFileFd, PqSendFileOffset,
+								PqSendFileLen);
+#endif
+		else
+			break;
 
 		if (r <= 0)
 		{
@@ -1402,20 +1425,43 @@ internal_flush(void)
 			 * the connection.
 			 */
 			PqSendStart = PqSendPointer = 0;
+			internal_dropfile();
 			ClientConnectionLost = 1;
 			InterruptPending = 1;
 			return EOF;
 		}
 
 		last_reported_send_errno = 0;	/* reset after any successful send */
-		bufptr += r;
-		PqSendStart += r;
+		if (bufptr < bufend)
+			PqSendStart += r;
+		else
+		{
+			PqSendFileOffset += r;
+			PqSendFileLen -= r;
+			if (PqSendFileLen == 0)
+				internal_dropfile();
+		}
 	}
 
 	PqSendStart = PqSendPointer = 0;
 	return 0;
 }
 
+/* --------------------------------
+ *		internal_dropfile - forget about the pending file chunk, if any
+ * --------------------------------
+ */
+static void
+internal_dropfile(void)
+{
+	if (PqSendFileFd >= 0)
+	{
+		close(PqSendFileFd);
+		PqSendFileFd = -1;
+	}
+	PqSendFileLen = 0;
+}
+
 /* --------------------------------
  *		pq_flush_if_writable - flush pending output if writable without blocking
  *
@@ -1428,7 +1474,7 @@ socket_flush_if_writable(void)
 	int			res;
 
 	/* Quick exit if nothing to do */
-	if (PqSendPointer == PqSendStart)
+	if (!socket_is_send_pending())
 		return 0;
 
 	/* No-op if reentrant call */
@@ -1451,7 +1497,7 @@ socket_flush_if_writable(void)
 static bool
 socket_is_send_pending(void)
 {
-	return (PqSendStart < PqSendPointer);
+	return (PqSendStart < PqSendPointer || PqSendFileFd >= 0);
 }
 
 /* --------------------------------
@@ -1532,6 +1578,77 @@ socket_putmessage_noblock(char msgtype, const char *s, size_t len)
 								 * buffer */
 }
 
+/* --------------------------------
+ *		pq_putmessage_file_noblock - like pq_putmessage_noblock, but the
+ *		message body continues with filelen bytes of file fd from offset
+ *
+ *		The file data is later sent directly from the file with sendfile(),
+ *		without being copied into the output buffer.  That's only possible on
+ *		an unencrypted socket connection, and with no other file chunk still
+ *		pending; returns false, without doing anything, if it's not possible.
+ *		The caller must then send the message the ordinary way.
+ *
+ *		fd is duplicated, so the caller doesn't need to keep it open.  The
+ *		caller must make sure the file contents don't change until sent.
+ * --------------------------------
+ */
+bool
+pq_putmessage_file_noblock(char msgtype, const char *s, size_t len,
+						   int fd, off_t offset, size_t filelen)
+{
+#ifdef PQ_HAVE_SENDFILE
+	int			res PG_USED_FOR_ASSERTS_ONLY;
+	int			required;
+	uint32		n32;
+	int			dupfd;
+
+	if (PqCommMethods != &PqCommSocketMethods || MyProcPort == NULL)
+		return false;
+#ifdef USE_SSL
+	if (MyProcPort->ssl_in_use)
+		return false;
+#endif
+#ifdef ENABLE_GSS
+	if (MyProcPort->gss && MyProcPort->gss->enc)
+		return false;
+#endif
+	if (PqSendFileFd >= 0 || PqCommBusy || filelen == 0 ||
+		len + filelen > PG_UINT32_MAX - 4)
+		return false;
+
+	dupfd = dup(fd);
+	if (dupfd < 0)
+		return false;
+
+	/* make room for the message header and the in-memory part */
+	required = PqSendPointer + 1 + 4 + len;
+	if (required > PqSendBufferSize)
+	{
+		PqSendBuffer = repalloc(PqSendBuffer, required);
+		PqSendBufferSize = required;
+	}
+
+	PqCommBusy = true;
+	res = internal_putbytes(&msgtype, 1);
+	Assert(res == 0);
+	n32 = pg_hton32((uint32) (len + filelen + 4));
+	res = internal_putbytes((char *) &n32, 4);
+	Assert(res == 0);
+	res = internal_putbytes(s, len);
+	Assert(res == 0);
+	PqCommBusy = false;
+
+	PqSendFileFd = dupfd;
+	PqSendFileOffset = offset;
+	PqSendFileLen = filelen;
+	PqSendFileAt = PqSendPointer;
+
+	return true;
+#else
+	return false;
+#endif							/* PQ_HAVE_SENDFILE */
+}
+
 /* --------------------------------
  *		pq_putmessage_v2 - send a message in protocol version 2
  *
@@ -30,6 +30,9 @@
 #ifdef HAVE_SYS_SHM_H
 #include <sys/shm.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include "miscadmin.h"
 #include "port/pg_bitutils.h"
@@ -557,6 +560,68 @@ GetHugePageSize(Size *hugepagesize, int *mmap_flags)
 
 #endif							/* MAP_HUGETLB */
 
+/*
+ * Linux memory policy support.  We invoke mbind(2) and get_mempolicy(2)
+ * directly rather than depending on libnuma, so the constants we need from
+ * <numaif.h> are spelled out here.
+ */
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_get_mempolicy)
+#define PG_HAVE_MEMPOLICY
+#define PG_MPOL_INTERLEAVE		3
+#define PG_MPOL_F_MEMS_ALLOWED	(1 << 2)
+#define PG_MAX_NUMA_NODES		1024
+#endif
+
+/*
+ * PGSharedMemoryInterleave
+ *
+ * If shared_memory_numa_interleave is enabled, ask the kernel to spread the
+ * pages of the given shared mapping round-robin across all the NUMA nodes
+ * we're allowed to allocate memory on.  The policy is attached to the
+ * underlying shared memory object, so it applies no matter which process
+ * first touches a page.  That keeps shared_buffers, the lock tables and the
+ * ProcArray from all landing on the node the postmaster happened to run on,
+ * which otherwise makes every backend on the other sockets pay for remote
+ * memory accesses.
+ *
+ * This must be called before the memory is first touched; pages that have
+ * already been faulted in are not migrated.  Failure is not fatal, since the
+ * only consequence is less favorable memory placement.  Callers pass elevel
+ * to control how loudly that's reported.
+ */
+void
+PGSharedMemoryInterleave(void *address, Size size, int elevel)
+{
+#ifdef PG_HAVE_MEMPOLICY
+	unsigned long nodemask[PG_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+	int			nnodes = 0;
+
+	if (!shared_memory_numa_interleave)
+		return;
+
+	memset(nodemask, 0, sizeof(nodemask));
+	if (syscall(SYS_get_mempolicy, NULL, nodemask, PG_MAX_NUMA_NODES,
+				NULL, PG_MPOL_F_MEMS_ALLOWED) != 0)
+	{
+		ereport(elevel,
+				(errmsg("could not determine allowed NUMA nodes: %m")));
+		return;
+	}
+
+	for (int i = 0; i < lengthof(nodemask); i++)
+		nnodes += pg_popcount64((uint64) nodemask[i]);
+
+	/* Nothing to do on a machine with a single memory node */
+	if (nnodes <= 1)
+		return;
+
+	if (syscall(SYS_mbind, address, size, PG_MPOL_INTERLEAVE,
+				nodemask, PG_MAX_NUMA_NODES, 0) != 0)
+		ereport(elevel,
+				(errmsg("could not interleave shared memory across NUMA nodes: %m")));
+#endif
+}
+
 /*
  * Creates an anonymous mmap()ed shared memory segment.
  *
@@ -607,6 +672,15 @@ CreateAnonymousSegment(Size *size)
 		ptr = mmap(NULL, allocsize, PROT_READ | PROT_WRITE,
 				   PG_MMAP_FLAGS, -1, 0);
 		mmap_errno = errno;
+
+#ifdef MADV_HUGEPAGE
+		/*
+		 * Without explicit huge pages, the kernel may still be willing to
+		 * back shared anonymous memory with transparent huge pages if asked.
+		 */
+		if (ptr != MAP_FAILED && huge_pages == HUGE_PAGES_TRY)
+			(void) madvise(ptr, allocsize, MADV_HUGEPAGE);
+#endif
 	}
 
 	if (ptr == MAP_FAILED)
@@ -794,6 +868,15 @@ PGSharedMemoryCreate(Size size,
 			elog(LOG, "shmdt(%p) failed: %m", oldhdr);
 	}
 
+	/*
+	 * Set the NUMA placement policy before anything in the segment is
+	 * touched.  In the anonymous case the System V block is only a shim.
+	 */
+	if (AnonymousShmem != NULL)
+		PGSharedMemoryInterleave(AnonymousShmem, AnonymousShmemSize, LOG);
+	else
+		PGSharedMemoryInterleave(memAddress, size, LOG);
+
 	/* Initialize new segment. */
 	hdr = (PGShmemHeader *) memAddress;
 	hdr->creatorPID = getpid();
@@ -605,3 +605,13 @@ pgwin32_ReserveSharedMemoryRegion(HANDLE hChild)
 
 	return true;
 }
+
+/*
+ * PGSharedMemoryInterleave
+ *
+ * NUMA placement of shared memory isn't supported on Windows.
+ */
+void
+PGSharedMemoryInterleave(void *address, Size size, int elevel)
+{
+}
@@ -0,0 +1,706 @@
+/*-------------------------------------------------------------------------
+ *
+ * autoprewarm.c
+ *	  Periodically dump the list of blocks in shared buffers, and reload
+ *	  them into shared buffers after a restart.
+ *
+ * If autoprewarm is enabled, the postmaster registers a leader background
+ * worker at startup.  The leader first reloads the blocks listed in the dump
+ * file left by the previous server run, if any, and then writes a new dump
+ * file every autoprewarm_interval seconds, and once more at shutdown.
+ *
+ * The dump file holds one fixed-size record per valid buffer, identifying
+ * the block and its usage count at dump time.  To reload the blocks, the
+ * leader sorts the records by database and physical location, copies them
+ * into a dynamic shared memory segment, and starts one worker per database
+ * in turn, since loading a block requires a connection to the database it
+ * belongs to.  Each worker loads the blocks with the highest usage count
+ * first, and within each usage count in physical order, prefetching ahead
+ * so that the reads are large and sequential wherever possible.  All of this
+ * happens while the server is already accepting connections.  Prewarming
+ * stops early when there are no more free buffers, so it never evicts pages
+ * that were read in since startup.
+ *
+ * Portions Copyright (c) 1996-2021, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/postmaster/autoprewarm.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "access/relation.h"
+#include "access/xact.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/pg_crc32c.h"
+#include "postmaster/autoprewarm.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/buf_internals.h"
+#include "storage/bufmgr.h"
+#include "storage/dsm.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lmgr.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "tcop/tcopprot.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/relfilenodemap.h"
+#include "utils/timestamp.h"
+
+/* distinct from contrib/pg_prewarm's "autoprewarm.blocks" text file */
+#define AUTOPREWARM_FILE		"pg_autoprewarm.blocks"
+#define AUTOPREWARM_FILE_MAGIC	0x41505731	/* "APW1" */
+
+/* Identity of one block in the dump file, and how hot it was */
+typedef struct BlockInfoRecord
+{
+	Oid			database;
+	Oid			tablespace;
+	Oid			filenode;
+	ForkNumber	forknum;
+	BlockNumber blocknum;
+	uint32		usagecount;
+} BlockInfoRecord;
+
+/* Dump file header */
+typedef struct AutoPrewarmFileHeader
+{
+	uint32		magic;			/* AUTOPREWARM_FILE_MAGIC */
+	uint32		blcksz;			/* BLCKSZ of the server that wrote it */
+	uint64		nblocks;		/* number of BlockInfoRecords that follow */
+	pg_crc32c	crc;			/* CRC of all the BlockInfoRecords */
+} AutoPrewarmFileHeader;
+
+/*
+ * Contents of the dynamic shared memory segment handed to the per-database
+ * workers.  The records are sorted with apw_compare_blockinfo.
+ */
+typedef struct AutoPrewarmState
+{
+	int			prewarmed_blocks;	/* blocks loaded so far */
+	bool		buffers_full;	/* a worker ran out of free buffers */
+	BlockInfoRecord blocks[FLEXIBLE_ARRAY_MEMBER];
+} AutoPrewarmState;
+
+/* Range of records to load, passed to a per-database worker in bgw_extra */
+typedef struct AutoPrewarmWorkerArgs
+{
+	Oid			database;
+	int			start_idx;
+	int			stop_idx;
+} AutoPrewarmWorkerArgs;
+
+/*
+ * Shared memory state.  The leader is restarted if it exits abnormally, but
+ * the dump file should only be loaded once per server start; after that, it
+ * may well describe buffers that have long been replaced.
+ */
+typedef struct AutoPrewarmSharedState
+{
+	pg_atomic_flag prewarm_started;
+} AutoPrewarmSharedState;
+
+/* GUC variables */
+bool		autoprewarm = false;
+int			autoprewarm_interval = 300;
+
+static AutoPrewarmSharedState *AutoPrewarmShared = NULL;
+
+static bool apw_load_buffers(void);
+static void apw_prewarm_range(dsm_segment *seg, int start_idx, int stop_idx);
+static void apw_dump_now(bool dump_unlogged);
+static int	apw_compare_blockinfo(const void *p, const void *q);
+
+
+/*
+ * AutoPrewarmRegister
+ *		Register the autoprewarm leader background worker, if enabled.
+ *
+ * Like ApplyLauncherRegister(), this must be called in the postmaster
+ * before InitializeMaxBackends().
+ */
+void
+AutoPrewarmRegister(void)
+{
+	BackgroundWorker bgw;
+
+	if (!autoprewarm)
+		return;
+
+	memset(&bgw, 0, sizeof(bgw));
+	bgw.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	bgw.bgw_start_time = BgWorkerStart_ConsistentState;
+	snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
+	snprintf(bgw.bgw_function_name, BGW_MAXLEN, "AutoPrewarmMain");
+	snprintf(bgw.bgw_name, BGW_MAXLEN, "autoprewarm leader");
+	snprintf(bgw.bgw_type, BGW_MAXLEN, "autoprewarm leader");
+	bgw.bgw_restart_time = 10;
+	bgw.bgw_notify_pid = 0;
+	bgw.bgw_main_arg = (Datum) 0;
+
+	RegisterBackgroundWorker(&bgw);
+}
+
+/*
+ * AutoPrewarmShmemSize
+ *		Compute space needed for autoprewarm's shared memory state
+ */
+Size
+AutoPrewarmShmemSize(void)
+{
+	return sizeof(AutoPrewarmSharedState);
+}
+
+/*
+ * AutoPrewarmShmemInit
+ *		Allocate and initialize autoprewarm's shared memory state
+ */
+void
+AutoPrewarmShmemInit(void)
+{
+	bool		found;
+
+	AutoPrewarmShared = (AutoPrewarmSharedState *)
+		ShmemInitStruct("Autoprewarm Data", AutoPrewarmShmemSize(), &found);
+
+	if (!found)
+		pg_atomic_init_flag(&AutoPrewarmShared->prewarm_started);
+}
+
+/*
+ * AutoPrewarmMain
+ *		Main entry point for the autoprewarm leader process.
+ */
+void
+AutoPrewarmMain(Datum main_arg)
+{
+	bool		dump_at_shutdown;
+	TimestampTz last_dump_time;
+
+	/* Establish signal handlers; once that's done, unblock signals. */
+	pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+	pqsignal(SIGHUP, SignalHandlerForConfigReload);
+	BackgroundWorkerUnblockSignals();
+
+	/*
+	 * Reload the blocks listed in the previous dump file, unless an earlier
+	 * incarnation of the leader already did (or started to) since the server
+	 * started.  If loading gets interrupted by a shutdown request, don't
+	 * overwrite the file at exit with the incomplete contents of shared
+	 * buffers.
+	 */
+	if (pg_atomic_test_set_flag(&AutoPrewarmShared->prewarm_started))
+		dump_at_shutdown = apw_load_buffers();
+	else
+		dump_at_shutdown = true;
+
+	/* Periodically dump buffers until terminated. */
+	last_dump_time = GetCurrentTimestamp();
+	while (!ShutdownRequestPending)
+	{
+		if (ConfigReloadPending)
+		{
+			ConfigReloadPending = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		if (autoprewarm_interval <= 0)
+		{
+			/* We're only dumping at shutdown, so just wait forever. */
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_EXIT_ON_PM_DEATH,
+							 -1L,
+							 WAIT_EVENT_AUTOPREWARM_MAIN);
+		}
+		else
+		{
+			TimestampTz next_dump_time;
+			long		delay_in_ms;
+
+			next_dump_time =
+				TimestampTzPlusMilliseconds(last_dump_time,
+											autoprewarm_interval * 1000L);
+			delay_in_ms = TimestampDifferenceMilliseconds(GetCurrentTimestamp(),
+														  next_dump_time);
+
+			/* Perform a dump if it's time. */
+			if (delay_in_ms <= 0)
+			{
+				last_dump_time = GetCurrentTimestamp();
+				apw_dump_now(false);
+				dump_at_shutdown = true;
+				continue;
+			}
+
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+							 delay_in_ms,
+							 WAIT_EVENT_AUTOPREWARM_MAIN);
+		}
+
+		ResetLatch(MyLatch);
+	}
+
+	/*
+	 * Dump one last time.  Buffers of unlogged relations survive a clean
+	 * shutdown, so include them in this one.
+	 */
+	if (dump_at_shutdown)
+		apw_dump_now(true);
+
+	proc_exit(0);
+}
+
+/*
+ * Read the dump file and load the blocks it lists, one database at a time.
+ *
+ * Returns false if we were interrupted by a shutdown request, else true.
+ */
+static bool
+apw_load_buffers(void)
+{
+	FILE	   *file;
+	AutoPrewarmFileHeader hdr;
+	dsm_segment *seg;
+	AutoPrewarmState *state;
+	Size		records_size;
+	pg_crc32c	crc;
+	int			nblocks;
+	int			start_idx;
+
+	file = AllocateFile(AUTOPREWARM_FILE, PG_BINARY_R);
+	if (file == NULL)
+	{
+		if (errno != ENOENT)
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m",
+							AUTOPREWARM_FILE)));
+		return true;			/* nothing to do */
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, file) != 1 ||
+		hdr.magic != AUTOPREWARM_FILE_MAGIC ||
+		hdr.blcksz != BLCKSZ ||
+		hdr.nblocks > MaxAllocHugeSize / sizeof(BlockInfoRecord) ||
+		hdr.nblocks > INT_MAX)
+	{
+		ereport(LOG,
+				(errmsg("ignoring invalid autoprewarm file \"%s\"",
+						AUTOPREWARM_FILE)));
+		FreeFile(file);
+		return true;
+	}
+
+	if (hdr.nblocks == 0)
+	{
+		FreeFile(file);
+		return true;
+	}
+
+	/* Read the records straight into the segment we'll give the workers. */
+	nblocks = (int) hdr.nblocks;
+	records_size = mul_size(nblocks, sizeof(BlockInfoRecord));
+	seg = dsm_create(add_size(offsetof(AutoPrewarmState, blocks),
+							  records_size), 0);
+	state = (AutoPrewarmState *) dsm_segment_address(seg);
+	state->prewarmed_blocks = 0;
+	state->buffers_full = false;
+
+	if (fread(state->blocks, sizeof(BlockInfoRecord), nblocks, file) !=
+		(size_t) nblocks)
+	{
+		ereport(LOG,
+				(errmsg("ignoring invalid autoprewarm file \"%s\"",
+						AUTOPREWARM_FILE)));
+		FreeFile(file);
+		dsm_detach(seg);
+		return true;
+	}
+	FreeFile(file);
+
+	INIT_CRC32C(crc);
+	COMP_CRC32C(crc, state->blocks, records_size);
+	FIN_CRC32C(crc);
+	if (!EQ_CRC32C(crc, hdr.crc))
+	{
+		ereport(LOG,
+				(errmsg("ignoring autoprewarm file \"%s\" with incorrect checksum",
+						AUTOPREWARM_FILE)));
+		dsm_detach(seg);
+		return true;
+	}
+
+	/* Sort by database and physical location. */
+	qsort(state->blocks, nblocks, sizeof(BlockInfoRecord),
+		  apw_compare_blockinfo);
+
+	/*
+	 * Start a worker for each database in turn.  Blocks of shared relations
+	 * sort first, with database InvalidOid; since a worker can't access them
+	 * without connecting to some database, they're loaded along with the
+	 * first real database.
+	 */
+	start_idx = 0;
+	while (start_idx < nblocks && !ShutdownRequestPending)
+	{
+		int			stop_idx = start_idx;
+		Oid			database;
+
+		/* Skip past shared relations, and then one database. */
+		while (stop_idx < nblocks &&
+			   state->blocks[stop_idx].database == InvalidOid)
+			stop_idx++;
+		if (stop_idx >= nblocks)
+			break;				/* only shared relations left, give up */
+		database = state->blocks[stop_idx].database;
+		while (stop_idx < nblocks &&
+			   state->blocks[stop_idx].database == database)
+			stop_idx++;
+
+		apw_prewarm_range(seg, start_idx, stop_idx);
+
+		if (state->buffers_full)
+			break;
+
+		start_idx = stop_idx;
+	}
+
+	ereport(LOG,
+			(errmsg("autoprewarm successfully prewarmed %d of %d previously-loaded blocks",
+					state->prewarmed_blocks, nblocks)));
+
+	dsm_detach(seg);
+
+	return !ShutdownRequestPending;
+}
+
+/*
+ * Start a per-database worker to load the given range of records, and wait
+ * for it to finish.
+ */
+static void
+apw_prewarm_range(dsm_segment *seg, int start_idx, int stop_idx)
+{
+	AutoPrewarmState *state = (AutoPrewarmState *) dsm_segment_address(seg);
+	BackgroundWorker bgw;
+	BackgroundWorkerHandle *handle;
+	AutoPrewarmWorkerArgs args;
+	BgwHandleStatus status;
+	pid_t		pid;
+
+	args.database = state->blocks[stop_idx - 1].database;
+	args.start_idx = start_idx;
+	args.stop_idx = stop_idx;
+
+	memset(&bgw, 0, sizeof(bgw));
+	bgw.bgw_flags = BGWORKER_SHMEM_ACCESS |
+		BGWORKER_BACKEND_DATABASE_CONNECTION;
+	bgw.bgw_start_time = BgWorkerStart_ConsistentState;
+	bgw.bgw_restart_time = BGW_NEVER_RESTART;
+	snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
+	snprintf(bgw.bgw_function_name, BGW_MAXLEN, "AutoPrewarmDatabaseMain");
+	snprintf(bgw.bgw_name, BGW_MAXLEN, "autoprewarm worker");
+	snprintf(bgw.bgw_type, BGW_MAXLEN, "autoprewarm worker");
+	bgw.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(seg));
+	bgw.bgw_notify_pid = MyProcPid;
+	memcpy(bgw.bgw_extra, &args, sizeof(args));
+
+	if (!RegisterDynamicBackgroundWorker(&bgw, &handle))
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+				 errmsg("registering dynamic bgworker autoprewarm failed"),
+				 errhint("Consider increasing configuration parameter \"max_worker_processes\".")));
+		return;
+	}
+
+	status = WaitForBackgroundWorkerStartup(handle, &pid);
+	if (status == BGWH_STARTED)
+		(void) WaitForBackgroundWorkerShutdown(handle);
+
+	pfree(handle);
+}
+
+/*
+ * AutoPrewarmDatabaseMain
+ *		Main entry point for a per-database autoprewarm worker.
+ *
+ * Loads the blocks in the range of records given in bgw_extra, which all
+ * belong to a single database or to shared relations.
+ */
+void
+AutoPrewarmDatabaseMain(Datum main_arg)
+{
+	dsm_segment *seg;
+	AutoPrewarmState *state;
+	AutoPrewarmWorkerArgs args;
+	int			usagecount;
+	int			prewarmed_blocks = 0;
+
+	/* Establish signal handlers; once that's done, unblock signals. */
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	memcpy(&args, MyBgworkerEntry->bgw_extra, sizeof(args));
+
+	seg = dsm_attach(DatumGetUInt32(main_arg));
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	state = (AutoPrewarmState *) dsm_segment_address(seg);
+
+	BackgroundWorkerInitializeConnectionByOid(args.database, InvalidOid, 0);
+
+	/*
+	 * Make one pass over the range for each usage count, hottest first.  Each
+	 * pass reads its blocks in physical order.
+	 */
+	for (usagecount = BM_MAX_USAGE_COUNT; usagecount >= 0; usagecount--)
+	{
+		Relation	rel = NULL;
+		Oid			tablespace = InvalidOid;
+		Oid			filenode = InvalidOid;
+		ForkNumber	forknum = InvalidForkNumber;
+		BlockNumber nblocks = 0;
+		int			prefetch_idx = args.start_idx;
+		int			i;
+
+		for (i = args.start_idx; i < args.stop_idx; i++)
+		{
+			BlockInfoRecord *blk = &state->blocks[i];
+			Buffer		buf;
+
+			if (blk->usagecount != usagecount)
+				continue;
+
+			CHECK_FOR_INTERRUPTS();
+
+			/*
+			 * Stop once there are no free buffers left, so that we don't
+			 * evict pages that were read since startup.
+			 */
+			if (!have_free_buffer())
+			{
+				state->buffers_full = true;
+				break;
+			}
+
+			/* Moving on to another relation? */
+			if (blk->tablespace != tablespace || blk->filenode != filenode)
+			{
+				Oid			reloid;
+
+				if (rel != NULL)
+				{
+					relation_close(rel, AccessShareLock);
+					rel = NULL;
+					CommitTransactionCommand();
+				}
+
+				tablespace = blk->tablespace;
+				filenode = blk->filenode;
+				forknum = InvalidForkNumber;
+
+				StartTransactionCommand();
+				reloid = RelidByRelfilenode(tablespace, filenode);
+				if (OidIsValid(reloid))
+					rel = try_relation_open(reloid, AccessShareLock);
+				if (rel == NULL)
+					CommitTransactionCommand();
+			}
+
+			/* If the relation is gone, skip its blocks. */
+			if (rel == NULL)
+				continue;
+
+			/* Moving on to another fork? */
+			if (blk->forknum != forknum)
+			{
+				forknum = blk->forknum;
+				RelationOpenSmgr(rel);
+				if (forknum > InvalidForkNumber && forknum <= MAX_FORKNUM &&
+					smgrexists(rel->rd_smgr, forknum))
+					nblocks = RelationGetNumberOfBlocksInFork(rel, forknum);
+				else
+					nblocks = 0;
+				prefetch_idx = i;
+			}
+
+			/* The relation may have been truncated since the dump. */
+			if (blk->blocknum >= nblocks)
+				continue;
+
+			/*
+			 * Keep up to maintenance_io_concurrency blocks of the same fork
+			 * prefetched ahead of the one we're reading.
+			 */
+			if (prefetch_idx < i)
+				prefetch_idx = i;
+			while (prefetch_idx < args.stop_idx &&
+				   prefetch_idx < i + maintenance_io_concurrency)
+			{
+				BlockInfoRecord *pblk = &state->blocks[prefetch_idx];
+
+				if (pblk->tablespace != tablespace ||
+					pblk->filenode != filenode ||
+					pblk->forknum != forknum)
+					break;
+				if (pblk->usagecount == usagecount &&
+					pblk->blocknum < nblocks)
+					(void) PrefetchBuffer(rel, forknum, pblk->blocknum);
+				prefetch_idx++;
+			}
+
+			buf = ReadBufferExtended(rel, forknum, blk->blocknum, RBM_NORMAL,
+									 NULL);
+			ReleaseBuffer(buf);
+
+			prewarmed_blocks++;
+		}
+
+		if (rel != NULL)
+		{
+			relation_close(rel, AccessShareLock);
+			CommitTransactionCommand();
+		}
+
+		if (state->buffers_full)
+			break;
+	}
+
+	state->prewarmed_blocks += prewarmed_blocks;
+
+	dsm_detach(seg);
+}
+
+/*
+ * Write the list of blocks currently in shared buffers to the dump file.
+ *
+ * Buffers of unlogged relations are included only if dump_unlogged is true,
+ * since they won't survive a crash.
+ */
+static void
+apw_dump_now(bool dump_unlogged)
+{
+	char		transient_dump_file_path[MAXPGPATH];
+	FILE	   *file;
+	AutoPrewarmFileHeader hdr;
+	int			i;
+
+	snprintf(transient_dump_file_path, MAXPGPATH, "%s.tmp", AUTOPREWARM_FILE);
+	file = AllocateFile(transient_dump_file_path, PG_BINARY_W);
+	if (!file)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m",
+						transient_dump_file_path)));
+		return;
+	}
+
+	/* Leave room for the header; we'll fill it in at the end. */
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = AUTOPREWARM_FILE_MAGIC;
+	hdr.blcksz = BLCKSZ;
+	INIT_CRC32C(hdr.crc);
+	if (fwrite(&hdr, sizeof(hdr), 1, file) != 1)
+		goto write_error;
+
+	for (i = 0; i < NBuffers; i++)
+	{
+		BufferDesc *bufHdr = GetBufferDescriptor(i);
+		BlockInfoRecord blk;
+		uint32		buf_state;
+
+		/* Lock each buffer header before inspecting. */
+		buf_state = LockBufHdr(bufHdr);
+
+		if (!(buf_state & BM_TAG_VALID) ||
+			(!(buf_state & BM_PERMANENT) && !dump_unlogged))
+		{
+			UnlockBufHdr(bufHdr, buf_state);
+			continue;
+		}
+
+		/* Zero any padding, since the CRC covers it */
+		memset(&blk, 0, sizeof(blk));
+		blk.database = bufHdr->tag.rnode.dbNode;
+		blk.tablespace = bufHdr->tag.rnode.spcNode;
+		blk.filenode = bufHdr->tag.rnode.relNode;
+		blk.forknum = bufHdr->tag.forkNum;
+		blk.blocknum = bufHdr->tag.blockNum;
+		blk.usagecount = BUF_STATE_GET_USAGECOUNT(buf_state);
+
+		UnlockBufHdr(bufHdr, buf_state);
+
+		if (fwrite(&blk, sizeof(blk), 1, file) != 1)
+			goto write_error;
+		COMP_CRC32C(hdr.crc, &blk, sizeof(blk));
+		hdr.nblocks++;
+	}
+
+	FIN_CRC32C(hdr.crc);
+	if (fseek(file, 0, SEEK_SET) != 0 ||
+		fwrite(&hdr, sizeof(hdr), 1, file) != 1)
+		goto write_error;
+
+	if (FreeFile(file))
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m",
+						transient_dump_file_path)));
+		unlink(transient_dump_file_path);
+		return;
+	}
+
+	(void) durable_rename(transient_dump_file_path, AUTOPREWARM_FILE, LOG);
+
+	elog(DEBUG1, "wrote block details for " UINT64_FORMAT " blocks",
+		 hdr.nblocks);
+	return;
+
+write_error:
+	ereport(LOG,
+			(errcode_for_file_access(),
+			 errmsg("could not write to file \"%s\": %m",
+					transient_dump_file_path)));
+	FreeFile(file);
+	unlink(transient_dump_file_path);
+}
+
+/*
+ * qsort comparator for BlockInfoRecords: order by database, then physical
+ * location.
+ */
+static int
+apw_compare_blockinfo(const void *p, const void *q)
+{
+	const BlockInfoRecord *a = (const BlockInfoRecord *) p;
+	const BlockInfoRecord *b = (const BlockInfoRecord *) q;
+
+	if (a->database != b->database)
+		return (a->database > b->database) ? 1 : -1;
+	if (a->tablespace != b->tablespace)
+		return (a->tablespace > b->tablespace) ? 1 : -1;
+	if (a->filenode != b->filenode)
+		return (a->filenode > b->filenode) ? 1 : -1;
+	if (a->forknum != b->forknum)
+		return (a->forknum > b->forknum) ? 1 : -1;
+	if (a->blocknum != b->blocknum)
+		return (a->blocknum > b->blocknum) ? 1 : -1;
+	return 0;
+}
@@ -185,6 +185,14 @@ typedef struct av_relation
 								 * reloptions, or NULL if none */
 } av_relation;
 
+/* struct to rank the tables to vacuum and/or analyze, in do_autovacuum */
+typedef struct av_table_score
+{
+	Oid			ts_relid;
+	bool		ts_wraparound;	/* at risk of wraparound? */
+	double		ts_score;		/* see relation_needs_vacanalyze */
+} av_table_score;
+
 /* struct to keep track of tables to vacuum and/or analyze, after rechecking */
 typedef struct autovac_table
 {
@@ -336,7 +344,9 @@ static void relation_needs_vacanalyze(Oid relid, AutoVacOpts *relopts,
 									  Form_pg_class classForm,
 									  PgStat_StatTabEntry *tabentry,
 									  int effective_multixact_freeze_max_age,
-									  bool *dovacuum, bool *doanalyze, bool *wraparound);
+									  bool *dovacuum, bool *doanalyze, bool *wraparound,
+									  double *score);
+static int	av_table_score_cmp(const ListCell *a, const ListCell *b);
 
 static void autovacuum_do_vac_analyze(autovac_table *tab,
 									  BufferAccessStrategy bstrategy);
@@ -1961,6 +1971,7 @@ do_autovacuum(void)
 	TableScanDesc relScan;
 	Form_pg_database dbForm;
 	List	   *table_oids = NIL;
+	List	   *table_scores = NIL;
 	List	   *orphan_oids = NIL;
 	HASHCTL		ctl;
 	HTAB	   *table_toast_map;
@@ -2084,6 +2095,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		score;
 
 		if (classForm->relkind != RELKIND_RELATION &&
 			classForm->relkind != RELKIND_MATVIEW)
@@ -2124,11 +2136,19 @@ do_autovacuum(void)
 		/* Check if it needs vacuum or analyze */
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound,
+								  &score);
 
-		/* Relations that need work are added to table_oids */
+		/* Relations that need work are added to table_scores */
 		if (dovacuum || doanalyze)
-			table_oids = lappend_oid(table_oids, relid);
+		{
+			av_table_score *ts = palloc(sizeof(av_table_score));
+
+			ts->ts_relid = relid;
+			ts->ts_wraparound = wraparound;
+			ts->ts_score = score;
+			table_scores = lappend(table_scores, ts);
+		}
 
 		/*
 		 * Remember TOAST associations for the second pass.  Note: we must do
@@ -2177,6 +2197,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		score;
 
 		/*
 		 * We cannot safely process other backends' temp tables, so skip 'em.
@@ -2207,16 +2228,40 @@ do_autovacuum(void)
 
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound,
+								  &score);
 
 		/* ignore analyze for toast tables */
 		if (dovacuum)
-			table_oids = lappend_oid(table_oids, relid);
+		{
+			av_table_score *ts = palloc(sizeof(av_table_score));
+
+			ts->ts_relid = relid;
+			ts->ts_wraparound = wraparound;
+			ts->ts_score = score;
+			table_scores = lappend(table_scores, ts);
+		}
 	}
 
 	table_endscan(relScan);
 	table_close(classRel, AccessShareLock);
 
+	/*
+	 * Process the tables in order of urgency, rather than in pg_class order,
+	 * so that a table at risk of wraparound or badly in need of vacuuming
+	 * doesn't have to wait for lots of tables that are barely over their
+	 * thresholds.  This matters most when the worker doesn't get through the
+	 * whole list before the next one comes along.
+	 */
+	list_sort(table_scores, av_table_score_cmp);
+	foreach(cell, table_scores)
+	{
+		av_table_score *ts = lfirst(cell);
+
+		table_oids = lappend_oid(table_oids, ts->ts_relid);
+	}
+	list_free_deep(table_scores);
+
 	/*
 	 * Recheck orphan temporary tables, and if they still seem orphaned, drop
 	 * them.  We'll eat a transaction per dropped table, which might seem
@@ -3014,7 +3059,7 @@ recheck_relation_needs_vacanalyze(Oid relid,
 
 	relation_needs_vacanalyze(relid, avopts, classForm, tabentry,
 							  effective_multixact_freeze_max_age,
-							  dovacuum, doanalyze, wraparound);
+							  dovacuum, doanalyze, wraparound, NULL);
 
 	/* ignore ANALYZE for toast tables */
 	if (classForm->relkind == RELKIND_TOASTVALUE)
@@ -3057,6 +3102,13 @@ recheck_relation_needs_vacanalyze(Oid relid,
  * autovacuum_vacuum_threshold GUC variable.  Similarly, a vac_scale_factor
  * value < 0 is substituted with the value of
  * autovacuum_vacuum_scale_factor GUC variable.  Ditto for analyze.
+ *
+ * If score isn't NULL, it is set to a measure of how urgently the table
+ * needs attention: each of the criteria above is expressed as the ratio of
+ * its current value to the threshold that triggers autovacuum, and the
+ * largest ratio wins.  Thus a table that just crossed one of its thresholds
+ * scores about 1, whatever its size, and one whose dead tuples are ten times
+ * over the threshold scores 10.
  */
 static void
 relation_needs_vacanalyze(Oid relid,
@@ -3067,11 +3119,13 @@ relation_needs_vacanalyze(Oid relid,
  /* output params below */
 						  bool *dovacuum,
 						  bool *doanalyze,
-						  bool *wraparound)
+						  bool *wraparound,
+						  double *score)
 {
 	bool		force_vacuum;
 	bool		av_enabled;
 	float4		reltuples;		/* pg_class.reltuples */
+	double		urgency = 0.0;
 
 	/* constants from reloptions or GUC variables */
 	int			vac_base_thresh,
@@ -3159,11 +3213,25 @@ relation_needs_vacanalyze(Oid relid,
 	}
 	*wraparound = force_vacuum;
 
+	/* How close are we to a forced vacuum? */
+	if (TransactionIdIsNormal(classForm->relfrozenxid) &&
+		TransactionIdPrecedes(classForm->relfrozenxid, recentXid))
+		urgency = Max(urgency,
+					  (double) (recentXid - classForm->relfrozenxid) /
+					  Max(freeze_max_age, 1));
+	if (MultiXactIdIsValid(classForm->relminmxid) &&
+		MultiXactIdPrecedes(classForm->relminmxid, recentMulti))
+		urgency = Max(urgency,
+					  (double) (recentMulti - classForm->relminmxid) /
+					  Max(multixact_freeze_max_age, 1));
+
 	/* User disabled it in pg_class.reloptions?  (But ignore if at risk) */
 	if (!av_enabled && !force_vacuum)
 	{
 		*doanalyze = false;
 		*dovacuum = false;
+		if (score)
+			*score = urgency;
 		return;
 	}
 
@@ -3207,6 +3275,13 @@ relation_needs_vacanalyze(Oid relid,
 		*dovacuum = force_vacuum || (vactuples > vacthresh) ||
 			(vac_ins_base_thresh >= 0 && instuples > vacinsthresh);
 		*doanalyze = (anltuples > anlthresh);
+
+		/* Thresholds can be zero, avoid dividing by that */
+		urgency = Max(urgency, vactuples / Max(vacthresh, 1.0));
+		if (vac_ins_base_thresh >= 0)
+			urgency = Max(urgency, instuples / Max(vacinsthresh, 1.0));
+		if (classForm->relkind != RELKIND_TOASTVALUE)
+			urgency = Max(urgency, anltuples / Max(anlthresh, 1.0));
 	}
 	else
 	{
@@ -3222,6 +3297,28 @@ relation_needs_vacanalyze(Oid relid,
 	/* ANALYZE refuses to work with pg_statistic */
 	if (relid == StatisticRelationId)
 		*doanalyze = false;
+
+	if (score)
+		*score = urgency;
+}
+
+/*
+ * list_sort comparator for av_table_score entries: tables at risk of
+ * wraparound first, then by descending score.
+ */
+static int
+av_table_score_cmp(const ListCell *a, const ListCell *b)
+{
+	av_table_score *ta = lfirst(a);
+	av_table_score *tb = lfirst(b);
+
+	if (ta->ts_wraparound != tb->ts_wraparound)
+		return ta->ts_wraparound ? -1 : 1;
+	if (ta->ts_score > tb->ts_score)
+		return -1;
+	if (ta->ts_score < tb->ts_score)
+		return 1;
+	return 0;
 }
 
 /*
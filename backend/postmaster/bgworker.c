@@ -17,6 +17,7 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
+#include "postmaster/autoprewarm.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/interrupt.h"
 #include "postmaster/postmaster.h"
@@ -123,6 +124,12 @@ static const struct
 	{
 		"ParallelWorkerMain", ParallelWorkerMain
 	},
+	{
+		"AutoPrewarmMain", AutoPrewarmMain
+	},
+	{
+		"AutoPrewarmDatabaseMain", AutoPrewarmDatabaseMain
+	},
 	{
 		"ApplyLauncherMain", ApplyLauncherMain
 	},
@@ -507,8 +507,9 @@ CheckpointerMain(void)
 		 */
 		pgstat_send_bgwriter();
 
-		/* Send WAL statistics to the stats collector. */
+		/* Send WAL and LWLock statistics to the stats collector. */
 		pgstat_send_wal(true);
+		pgstat_send_lwlock(true);
 
 		/*
 		 * If any checkpoint flags have been set, redo the loop to handle the
@@ -587,6 +588,7 @@ HandleCheckpointerInterrupts(void)
 		ShutdownXLOG(0, 0);
 		pgstat_send_bgwriter();
 		pgstat_send_wal(true);
+		pgstat_send_lwlock(true);
 
 		/* Normal exit from the checkpointer is here */
 		proc_exit(0);			/* done */
@@ -728,6 +730,7 @@ CheckpointWriteDelay(int flags, double progress)
 		 * Report interim activity statistics to the stats collector.
 		 */
 		pgstat_send_bgwriter();
+		pgstat_send_lwlock(false);
 
 		/*
 		 * This sleep used to be connected to bgwriter_delay, typically 200ms.
@@ -130,6 +130,13 @@ char	   *pgstat_stat_tmpname = NULL;
 PgStat_MsgBgWriter BgWriterStats;
 PgStat_MsgWal WalStats;
 
+/*
+ * LWLock statistics counts waiting to be sent to the collector, indexed by
+ * tranche.  These are bumped directly by lwlock.c; the t_index fields are
+ * only filled in when building messages.  We assume this inits to zeroes.
+ */
+PgStat_LWLockEntry PendingLWLockStats[NUM_LWLOCK_STATS_TRANCHES];
+
 /*
  * WAL usage counters saved from pgWALUsage at the previous call to
  * pgstat_send_wal(). This is used to calculate how much WAL usage
@@ -278,6 +285,7 @@ static PgStat_ArchiverStats archiverStats;
 static PgStat_GlobalStats globalStats;
 static PgStat_WalStats walStats;
 static PgStat_SLRUStats slruStats[SLRU_NUM_ELEMENTS];
+static PgStat_LWLockStats lwlockStats[NUM_LWLOCK_STATS_TRANCHES];
 static HTAB *replSlotStatHash = NULL;
 
 /*
@@ -350,6 +358,7 @@ static void pgstat_recv_archiver(PgStat_MsgArchiver *msg, int len);
 static void pgstat_recv_bgwriter(PgStat_MsgBgWriter *msg, int len);
 static void pgstat_recv_wal(PgStat_MsgWal *msg, int len);
 static void pgstat_recv_slru(PgStat_MsgSLRU *msg, int len);
+static void pgstat_recv_lwlock(PgStat_MsgLWLock *msg, int len);
 static void pgstat_recv_funcstat(PgStat_MsgFuncstat *msg, int len);
 static void pgstat_recv_funcpurge(PgStat_MsgFuncpurge *msg, int len);
 static void pgstat_recv_recoveryconflict(PgStat_MsgRecoveryConflict *msg, int len);
@@ -961,8 +970,11 @@ pgstat_report_stat(bool disconnect)
 	/* Send WAL statistics */
 	pgstat_send_wal(true);
 
-	/* Finally send SLRU statistics */
+	/* Send SLRU statistics */
 	pgstat_send_slru();
+
+	/* Finally send LWLock statistics */
+	pgstat_send_lwlock(true);
 }
 
 /*
@@ -1438,11 +1450,13 @@ pgstat_reset_shared_counters(const char *target)
 		msg.m_resettarget = RESET_BGWRITER;
 	else if (strcmp(target, "wal") == 0)
 		msg.m_resettarget = RESET_WAL;
+	else if (strcmp(target, "lwlock") == 0)
+		msg.m_resettarget = RESET_LWLOCK;
 	else
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 				 errmsg("unrecognized reset target: \"%s\"", target),
-				 errhint("Target must be \"archiver\", \"bgwriter\", or \"wal\".")));
+				 errhint("Target must be \"archiver\", \"bgwriter\", \"wal\", or \"lwlock\".")));
 
 	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RESETSHAREDCOUNTER);
 	pgstat_send(&msg, sizeof(msg));
@@ -2870,6 +2884,23 @@ pgstat_fetch_slru(void)
 	return slruStats;
 }
 
+/*
+ * ---------
+ * pgstat_fetch_lwlock() -
+ *
+ *	Support function for the SQL-callable pgstat* functions. Returns
+ *	a pointer to the LWLock statistics array, which has
+ *	NUM_LWLOCK_STATS_TRANCHES entries.
+ * ---------
+ */
+PgStat_LWLockStats *
+pgstat_fetch_lwlock(void)
+{
+	backend_read_statsfile();
+
+	return lwlockStats;
+}
+
 /*
  * ---------
  * pgstat_fetch_replslot() -
@@ -3163,6 +3194,73 @@ pgstat_send_slru(void)
 	}
 }
 
+/* ----------
+ * pgstat_send_lwlock() -
+ *
+ *		Send LWLock statistics to the collector
+ *
+ * Regular backends send these from pgstat_report_stat(), but auxiliary
+ * processes and walsenders never call that, so they call this directly.
+ *
+ * If 'force' is not set, LWLock stats message is only sent if enough time
+ * has passed since last one was sent to reach PGSTAT_STAT_INTERVAL.
+ * ----------
+ */
+void
+pgstat_send_lwlock(bool force)
+{
+	static TimestampTz sendTime = 0;
+	PgStat_MsgLWLock msg;
+	int			len;
+
+	if (!force)
+	{
+		TimestampTz now = GetCurrentTimestamp();
+
+		/*
+		 * Don't send a message unless it's been at least PGSTAT_STAT_INTERVAL
+		 * msec since we last sent one to avoid overloading the stats
+		 * collector.
+		 */
+		if (!TimestampDifferenceExceeds(sendTime, now, PGSTAT_STAT_INTERVAL))
+			return;
+		sendTime = now;
+	}
+
+	msg.m_nentries = 0;
+
+	for (int i = 0; i < NUM_LWLOCK_STATS_TRANCHES; i++)
+	{
+		PgStat_LWLockEntry *entry = &PendingLWLockStats[i];
+
+		/* Skip tranches we haven't touched since the last report */
+		if (entry->t_acquisitions == 0 && entry->t_waits == 0 &&
+			entry->t_spins == 0)
+			continue;
+
+		entry->t_index = i;
+		memcpy(&msg.m_entry[msg.m_nentries], entry, sizeof(PgStat_LWLockEntry));
+		MemSet(entry, 0, sizeof(PgStat_LWLockEntry));
+
+		if (++msg.m_nentries >= PGSTAT_NUM_LWLOCKENTRIES)
+		{
+			len = offsetof(PgStat_MsgLWLock, m_entry[0]) +
+				msg.m_nentries * sizeof(PgStat_LWLockEntry);
+			pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_LWLOCK);
+			pgstat_send(&msg, len);
+			msg.m_nentries = 0;
+		}
+	}
+
+	if (msg.m_nentries > 0)
+	{
+		len = offsetof(PgStat_MsgLWLock, m_entry[0]) +
+			msg.m_nentries * sizeof(PgStat_LWLockEntry);
+		pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_LWLOCK);
+		pgstat_send(&msg, len);
+	}
+}
+
 
 /* ----------
  * PgstatCollectorMain() -
@@ -3377,6 +3475,10 @@ PgstatCollectorMain(int argc, char *argv[])
 					pgstat_recv_slru(&msg.msg_slru, len);
 					break;
 
+				case PGSTAT_MTYPE_LWLOCK:
+					pgstat_recv_lwlock(&msg.msg_lwlock, len);
+					break;
+
 				case PGSTAT_MTYPE_FUNCSTAT:
 					pgstat_recv_funcstat(&msg.msg_funcstat, len);
 					break;
@@ -3672,6 +3774,12 @@ pgstat_write_statsfiles(bool permanent, bool allDbs)
 	rc = fwrite(slruStats, sizeof(slruStats), 1, fpout);
 	(void) rc;					/* we'll check for error with ferror */
 
+	/*
+	 * Write LWLock stats struct
+	 */
+	rc = fwrite(lwlockStats, sizeof(lwlockStats), 1, fpout);
+	(void) rc;					/* we'll check for error with ferror */
+
 	/*
 	 * Walk through the database table.
 	 */
@@ -3940,13 +4048,14 @@ pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep)
 						 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 
 	/*
-	 * Clear out global, archiver, WAL and SLRU statistics so they start from
-	 * zero in case we can't load an existing statsfile.
+	 * Clear out global, archiver, WAL, SLRU and LWLock statistics so they
+	 * start from zero in case we can't load an existing statsfile.
 	 */
 	memset(&globalStats, 0, sizeof(globalStats));
 	memset(&archiverStats, 0, sizeof(archiverStats));
 	memset(&walStats, 0, sizeof(walStats));
 	memset(&slruStats, 0, sizeof(slruStats));
+	memset(&lwlockStats, 0, sizeof(lwlockStats));
 
 	/*
 	 * Set the current timestamp (will be kept only in case we can't load an
@@ -3962,6 +4071,10 @@ pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep)
 	for (i = 0; i < SLRU_NUM_ELEMENTS; i++)
 		slruStats[i].stat_reset_timestamp = globalStats.stat_reset_timestamp;
 
+	/* ... and for all LWLock tranches. */
+	for (i = 0; i < NUM_LWLOCK_STATS_TRANCHES; i++)
+		lwlockStats[i].stat_reset_timestamp = globalStats.stat_reset_timestamp;
+
 	/*
 	 * Try to open the stats file. If it doesn't exist, the backends simply
 	 * return zero for anything and the collector simply starts from scratch
@@ -4046,6 +4159,17 @@ pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep)
 		goto done;
 	}
 
+	/*
+	 * Read LWLock stats struct
+	 */
+	if (fread(lwlockStats, 1, sizeof(lwlockStats), fpin) != sizeof(lwlockStats))
+	{
+		ereport(pgStatRunningInCollector ? LOG : WARNING,
+				(errmsg("corrupted statistics file \"%s\"", statfile)));
+		memset(&lwlockStats, 0, sizeof(lwlockStats));
+		goto done;
+	}
+
 	/*
 	 * We found an existing collector stats file. Read it and put all the
 	 * hashtable entries into place.
@@ -4385,6 +4509,7 @@ pgstat_read_db_statsfile_timestamp(Oid databaseid, bool permanent,
 	PgStat_ArchiverStats myArchiverStats;
 	PgStat_WalStats myWalStats;
 	PgStat_SLRUStats mySLRUStats[SLRU_NUM_ELEMENTS];
+	PgStat_LWLockStats myLWLockStats[NUM_LWLOCK_STATS_TRANCHES];
 	PgStat_StatReplSlotEntry myReplSlotStats;
 	FILE	   *fpin;
 	int32		format_id;
@@ -4462,6 +4587,18 @@ pgstat_read_db_statsfile_timestamp(Oid databaseid, bool permanent,
 		return false;
 	}
 
+	/*
+	 * Read LWLock stats struct
+	 */
+	if (fread(myLWLockStats, 1, sizeof(myLWLockStats),
+			  fpin) != sizeof(myLWLockStats))
+	{
+		ereport(pgStatRunningInCollector ? LOG : WARNING,
+				(errmsg("corrupted statistics file \"%s\"", statfile)));
+		FreeFile(fpin);
+		return false;
+	}
+
 	/* By default, we're going to return the timestamp of the global file. */
 	*ts = myGlobalStats.stats_timestamp;
 
@@ -5064,6 +5201,15 @@ pgstat_recv_resetsharedcounter(PgStat_MsgResetsharedcounter *msg, int len)
 		memset(&walStats, 0, sizeof(walStats));
 		walStats.stat_reset_timestamp = GetCurrentTimestamp();
 	}
+	else if (msg->m_resettarget == RESET_LWLOCK)
+	{
+		/* Reset the LWLock statistics for the cluster. */
+		TimestampTz ts = GetCurrentTimestamp();
+
+		memset(&lwlockStats, 0, sizeof(lwlockStats));
+		for (int i = 0; i < NUM_LWLOCK_STATS_TRANCHES; i++)
+			lwlockStats[i].stat_reset_timestamp = ts;
+	}
 
 	/*
 	 * Presumably the sender of this message validated the target, don't
@@ -5361,6 +5507,32 @@ pgstat_recv_slru(PgStat_MsgSLRU *msg, int len)
 	slruStats[msg->m_index].truncate += msg->m_truncate;
 }
 
+/* ----------
+ * pgstat_recv_lwlock() -
+ *
+ *	Process an LWLock message.
+ * ----------
+ */
+static void
+pgstat_recv_lwlock(PgStat_MsgLWLock *msg, int len)
+{
+	for (int i = 0; i < msg->m_nentries; i++)
+	{
+		PgStat_LWLockEntry *entry = &msg->m_entry[i];
+		PgStat_LWLockStats *stats;
+
+		/* ignore tranches we don't know about, rather than crash */
+		if (entry->t_index < 0 || entry->t_index >= NUM_LWLOCK_STATS_TRANCHES)
+			continue;
+
+		stats = &lwlockStats[entry->t_index];
+		stats->acquisitions += entry->t_acquisitions;
+		stats->waits += entry->t_waits;
+		stats->spins += entry->t_spins;
+		stats->wait_time += entry->t_wait_time;
+	}
+}
+
 /* ----------
  * pgstat_recv_recoveryconflict() -
  *
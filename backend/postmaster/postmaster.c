@@ -108,6 +108,7 @@
 #include "pg_getopt.h"
 #include "pgstat.h"
 #include "port/pg_bswap.h"
+#include "postmaster/autoprewarm.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/fork_process.h"
@@ -525,6 +526,7 @@ typedef struct
 	bool		query_id_enabled;
 	int			max_safe_fds;
 	int			MaxBackends;
+	int			FastPathLockGroupsPerBackend;
 #ifdef WIN32
 	HANDLE		PostmasterHandle;
 	HANDLE		initial_signal_pipe;
@@ -997,6 +999,9 @@ PostmasterMain(int argc, char *argv[])
 	 */
 	ApplyLauncherRegister();
 
+	/* Likewise for the autoprewarm leader. */
+	AutoPrewarmRegister();
+
 	/*
 	 * process any libraries that should be preloaded at postmaster start
 	 */
@@ -1019,6 +1024,9 @@ PostmasterMain(int argc, char *argv[])
 	 */
 	InitializeMaxBackends();
 
+	/* Size the per-backend fast-path lock arrays, too. */
+	InitializeFastPathLocks();
+
 	/*
 	 * Set up shared memory and semaphores.
 	 */
@@ -6212,6 +6220,7 @@ save_backend_variables(BackendParameters *param, Port *port,
 	param->max_safe_fds = max_safe_fds;
 
 	param->MaxBackends = MaxBackends;
+	param->FastPathLockGroupsPerBackend = FastPathLockGroupsPerBackend;
 
 #ifdef WIN32
 	param->PostmasterHandle = PostmasterHandle;
@@ -6446,6 +6455,7 @@ restore_backend_variables(BackendParameters *param, Port *port)
 	max_safe_fds = param->max_safe_fds;
 
 	MaxBackends = param->MaxBackends;
+	FastPathLockGroupsPerBackend = param->FastPathLockGroupsPerBackend;
 
 #ifdef WIN32
 	PostmasterHandle = param->PostmasterHandle;
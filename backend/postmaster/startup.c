@@ -196,6 +196,9 @@ StartupProcExit(int code, Datum arg)
 	/* Shutdown the recovery environment */
 	if (standbyState != STANDBY_DISABLED)
 		ShutdownRecoveryTransactionEnvironment();
+
+	/* Send the LWLock statistics gathered during recovery */
+	pgstat_send_lwlock(true);
 }
 
 
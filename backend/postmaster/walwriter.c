@@ -257,8 +257,9 @@ WalWriterMain(void)
 		else if (left_till_hibernate > 0)
 			left_till_hibernate--;
 
-		/* Send WAL statistics to the stats collector */
+		/* Send WAL and LWLock statistics to the stats collector */
 		pgstat_send_wal(false);
+		pgstat_send_lwlock(false);
 
 		/*
 		 * Sleep until we are signaled or WalWriterDelay has elapsed.  If we
@@ -303,6 +304,7 @@ HandleWalWriterInterrupts(void)
 		 * stats counters for the WAL writer.
 		 */
 		pgstat_send_wal(true);
+		pgstat_send_lwlock(true);
 
 		proc_exit(0);
 	}
@@ -0,0 +1,364 @@
+/*-------------------------------------------------------------------------
+ *
+ * backup_compress.c
+ *	  code for compressing the tar streams of a base backup on the server
+ *
+ * When the client asks for it, each tar stream sent by BASE_BACKUP is run
+ * through a compressor before being sent as CopyData messages, so that the
+ * network only carries the compressed data.  gzip output can be read with
+ * gzip or zcat, and lz4 output is a regular LZ4 frame as written by the lz4
+ * command line tool.
+ *
+ * Portions Copyright (c) 2010-2021, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/backend/replication/backup_compress.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+
+#include "libpq/libpq.h"
+#include "replication/backup_compress.h"
+
+/* Size of the buffer the compressed data is collected in before sending */
+#define BACKUP_COMPRESS_BUFSIZE		(64 * 1024)
+
+/* older lz4 releases don't provide this */
+#if defined(USE_LZ4) && !defined(LZ4F_HEADER_SIZE_MAX)
+#define LZ4F_HEADER_SIZE_MAX	19
+#endif
+
+struct backup_compress_state
+{
+	backup_compression_type type;
+	char	   *outbuf;
+	size_t		outbufsize;
+	size_t		outbuflen;		/* valid bytes in outbuf */
+#ifdef HAVE_LIBZ
+	z_stream	zstream;
+#endif
+#ifdef USE_LZ4
+	LZ4F_compressionContext_t lz4ctx;
+	LZ4F_preferences_t lz4prefs;
+	size_t		lz4bound;		/* worst-case output for one input chunk */
+#endif
+};
+
+static void send_compressed_data(backup_compress_state *state);
+#ifdef HAVE_LIBZ
+static void *gzip_palloc(void *opaque, unsigned items, unsigned size);
+static void gzip_pfree(void *opaque, void *address);
+#endif
+
+/*
+ * Translate a compression method name given to BASE_BACKUP.  Returns false
+ * if the name is not recognized, or not supported by this build.
+ */
+bool
+ParseBackupCompressionType(const char *name, backup_compression_type *type)
+{
+	if (strcmp(name, "none") == 0)
+		*type = BACKUP_COMPRESSION_NONE;
+#ifdef HAVE_LIBZ
+	else if (strcmp(name, "gzip") == 0)
+		*type = BACKUP_COMPRESSION_GZIP;
+#endif
+#ifdef USE_LZ4
+	else if (strcmp(name, "lz4") == 0)
+		*type = BACKUP_COMPRESSION_LZ4;
+#endif
+	else
+		return false;
+
+	return true;
+}
+
+/*
+ * Start compressing a new tar stream.  level is the method-specific
+ * compression level, or 0 for the default.
+ */
+backup_compress_state *
+BeginBackupCompression(backup_compression_type type, int level)
+{
+	backup_compress_state *state;
+
+	Assert(type != BACKUP_COMPRESSION_NONE);
+
+	state = palloc0(sizeof(backup_compress_state));
+	state->type = type;
+	state->outbufsize = BACKUP_COMPRESS_BUFSIZE;
+
+	switch (type)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			break;
+
+		case BACKUP_COMPRESSION_GZIP:
+#ifdef HAVE_LIBZ
+			state->zstream.zalloc = gzip_palloc;
+			state->zstream.zfree = gzip_pfree;
+			state->zstream.opaque = Z_NULL;
+
+			/* windowBits + 16 asks for a gzip header and trailer */
+			if (deflateInit2(&state->zstream,
+							 level != 0 ? level : Z_DEFAULT_COMPRESSION,
+							 Z_DEFLATED, 15 + 16, 8,
+							 Z_DEFAULT_STRATEGY) != Z_OK)
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+						 errmsg("could not initialize compression library")));
+#endif
+			break;
+
+		case BACKUP_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			{
+				LZ4F_errorCode_t err;
+				size_t		len;
+
+				err = LZ4F_createCompressionContext(&state->lz4ctx,
+													LZ4F_VERSION);
+				if (LZ4F_isError(err))
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not create lz4 compression context: %s",
+									LZ4F_getErrorName(err))));
+
+				state->lz4prefs.compressionLevel = level;
+				state->lz4bound = LZ4F_compressBound(BACKUP_COMPRESS_BUFSIZE,
+													 &state->lz4prefs);
+
+				/* room for the frame header, plus one chunk's worth */
+				state->outbufsize = Max(state->outbufsize,
+										LZ4F_HEADER_SIZE_MAX + state->lz4bound);
+				state->outbuf = palloc(state->outbufsize);
+
+				len = LZ4F_compressBegin(state->lz4ctx, state->outbuf,
+										 state->outbufsize, &state->lz4prefs);
+				if (LZ4F_isError(len))
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not write lz4 header: %s",
+									LZ4F_getErrorName(len))));
+				state->outbuflen = len;
+			}
+#endif
+			break;
+	}
+
+	if (state->outbuf == NULL)
+		state->outbuf = palloc(state->outbufsize);
+
+	return state;
+}
+
+/*
+ * Compress some tar data, sending out compressed data as the output buffer
+ * fills up.
+ */
+void
+BackupCompressData(backup_compress_state *state, const char *data, size_t len)
+{
+	switch (state->type)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			break;
+
+		case BACKUP_COMPRESSION_GZIP:
+#ifdef HAVE_LIBZ
+			state->zstream.next_in = (Bytef *) data;
+			state->zstream.avail_in = len;
+
+			while (state->zstream.avail_in > 0)
+			{
+				if (state->outbuflen == state->outbufsize)
+					send_compressed_data(state);
+
+				state->zstream.next_out = (Bytef *) state->outbuf + state->outbuflen;
+				state->zstream.avail_out = state->outbufsize - state->outbuflen;
+
+				if (deflate(&state->zstream, Z_NO_FLUSH) == Z_STREAM_ERROR)
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not compress data: %s",
+									state->zstream.msg)));
+
+				state->outbuflen = state->outbufsize - state->zstream.avail_out;
+			}
+#endif
+			break;
+
+		case BACKUP_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			while (len > 0)
+			{
+				size_t		chunk = Min(len, BACKUP_COMPRESS_BUFSIZE);
+				size_t		written;
+
+				/* make sure the worst case fits in the output buffer */
+				if (state->outbufsize - state->outbuflen < state->lz4bound)
+					send_compressed_data(state);
+
+				written = LZ4F_compressUpdate(state->lz4ctx,
+											  state->outbuf + state->outbuflen,
+											  state->outbufsize - state->outbuflen,
+											  data, chunk, NULL);
+				if (LZ4F_isError(written))
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not compress data: %s",
+									LZ4F_getErrorName(written))));
+
+				state->outbuflen += written;
+				data += chunk;
+				len -= chunk;
+			}
+#endif
+			break;
+	}
+}
+
+/*
+ * Finish the compressed stream, send out whatever is left, and release the
+ * compression state.
+ */
+void
+EndBackupCompression(backup_compress_state *state)
+{
+	switch (state->type)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			break;
+
+		case BACKUP_COMPRESSION_GZIP:
+#ifdef HAVE_LIBZ
+			for (;;)
+			{
+				int			res;
+
+				if (state->outbuflen == state->outbufsize)
+					send_compressed_data(state);
+
+				state->zstream.next_in = NULL;
+				state->zstream.avail_in = 0;
+				state->zstream.next_out = (Bytef *) state->outbuf + state->outbuflen;
+				state->zstream.avail_out = state->outbufsize - state->outbuflen;
+
+				res = deflate(&state->zstream, Z_FINISH);
+				if (res == Z_STREAM_ERROR)
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not compress data: %s",
+									state->zstream.msg)));
+
+				state->outbuflen = state->outbufsize - state->zstream.avail_out;
+
+				if (res == Z_STREAM_END)
+					break;
+			}
+			deflateEnd(&state->zstream);
+#endif
+			break;
+
+		case BACKUP_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			{
+				size_t		written;
+
+				if (state->outbufsize - state->outbuflen < state->lz4bound)
+					send_compressed_data(state);
+
+				written = LZ4F_compressEnd(state->lz4ctx,
+										   state->outbuf + state->outbuflen,
+										   state->outbufsize - state->outbuflen,
+										   NULL);
+				if (LZ4F_isError(written))
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not end lz4 compression: %s",
+									LZ4F_getErrorName(written))));
+
+				state->outbuflen += written;
+				LZ4F_freeCompressionContext(state->lz4ctx);
+			}
+#endif
+			break;
+	}
+
+	send_compressed_data(state);
+
+	pfree(state->outbuf);
+	pfree(state);
+}
+
+/*
+ * Release the compression state without finishing the stream, after an
+ * error.  The compression libraries allocate some memory with malloc(),
+ * which would otherwise be leaked.
+ */
+void
+AbortBackupCompression(backup_compress_state *state)
+{
+	switch (state->type)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			break;
+
+		case BACKUP_COMPRESSION_GZIP:
+#ifdef HAVE_LIBZ
+			deflateEnd(&state->zstream);
+#endif
+			break;
+
+		case BACKUP_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			LZ4F_freeCompressionContext(state->lz4ctx);
+#endif
+			break;
+	}
+
+	pfree(state->outbuf);
+	pfree(state);
+}
+
+/*
+ * Send the contents of the output buffer as a CopyData message.
+ */
+static void
+send_compressed_data(backup_compress_state *state)
+{
+	if (state->outbuflen == 0)
+		return;
+
+	if (pq_putmessage('d', state->outbuf, state->outbuflen))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+
+	state->outbuflen = 0;
+}
+
+#ifdef HAVE_LIBZ
+/*
+ * Allocation and deallocation hooks for zlib, so that its memory is tracked
+ * in our memory contexts.
+ */
+static void *
+gzip_palloc(void *opaque, unsigned items, unsigned size)
+{
+	return palloc(items * size);
+}
+
+static void
+gzip_pfree(void *opaque, void *address)
+{
+	pfree(address);
+}
+#endif
@@ -30,6 +30,7 @@
 #include "port.h"
 #include "postmaster/syslogger.h"
 #include "replication/basebackup.h"
+#include "replication/backup_compress.h"
 #include "replication/backup_manifest.h"
 #include "replication/walsender.h"
 #include "replication/walsender_private.h"
@@ -56,6 +57,8 @@ typedef struct
 	bool		sendtblspcmapfile;
 	backup_manifest_option manifest;
 	pg_checksum_type manifest_checksum_type;
+	backup_compression_type compression;
+	int			compression_level;
 } basebackup_options;
 
 static int64 sendTablespace(char *path, char *oid, bool sizeonly,
@@ -73,6 +76,9 @@ static int64 _tarWriteHeader(const char *filename, const char *linktarget,
 static int64 _tarWriteDir(const char *pathbuf, int basepathlen, struct stat *statbuf,
 						  bool sizeonly);
 static void send_int8_string(StringInfoData *buf, int64 intval);
+static void begin_tar_stream(basebackup_options *opt);
+static void send_tar_data(const char *data, size_t len);
+static void end_tar_stream(void);
 static void SendBackupHeader(List *tablespaces);
 static void perform_base_backup(basebackup_options *opt);
 static void parse_basebackup_options(List *options, basebackup_options *opt);
@@ -130,6 +136,9 @@ static int64 backup_total = 0;
 /* Amount of backup data already streamed */
 static int64 backup_streamed = 0;
 
+/* Compression state of the tar stream being sent, if it's compressed */
+static backup_compress_state *compress_state = NULL;
+
 /*
  * Definition of one element part of an exclusion list, used for paths part
  * of checksum validation or base backups.  "name" is the name of the file
@@ -266,6 +275,7 @@ perform_base_backup(basebackup_options *opt)
 
 	backup_total = 0;
 	backup_streamed = 0;
+	Assert(compress_state == NULL);
 	pgstat_progress_start_command(PROGRESS_COMMAND_BASEBACKUP, InvalidOid);
 
 	/*
@@ -403,13 +413,8 @@ perform_base_backup(basebackup_options *opt)
 		foreach(lc, tablespaces)
 		{
 			tablespaceinfo *ti = (tablespaceinfo *) lfirst(lc);
-			StringInfoData buf;
 
-			/* Send CopyOutResponse message */
-			pq_beginmessage(&buf, 'H');
-			pq_sendbyte(&buf, 0);	/* overall format */
-			pq_sendint16(&buf, 0);	/* natts */
-			pq_endmessage(&buf);
+			begin_tar_stream(opt);
 
 			if (ti->path == NULL)
 			{
@@ -455,7 +460,7 @@ perform_base_backup(basebackup_options *opt)
 				Assert(lnext(tablespaces, lc) == NULL);
 			}
 			else
-				pq_putemptymessage('c');	/* CopyDone */
+				end_tar_stream();
 
 			tblspc_streamed++;
 			pgstat_progress_update_param(PROGRESS_BASEBACKUP_TBLSPC_STREAMED,
@@ -638,10 +643,7 @@ perform_base_backup(basebackup_options *opt)
 											   len, pathbuf, true)) > 0)
 			{
 				CheckXLogRemoved(segno, tli);
-				/* Send the chunk as a CopyData message */
-				if (pq_putmessage('d', buf, cnt))
-					ereport(ERROR,
-							(errmsg("base backup could not send data, aborting backup")));
+				send_tar_data(buf, cnt);
 				update_basebackup_progress(cnt);
 
 				len += cnt;
@@ -706,7 +708,7 @@ perform_base_backup(basebackup_options *opt)
 		}
 
 		/* Send CopyDone message for the last tar file */
-		pq_putemptymessage('c');
+		end_tar_stream();
 	}
 
 	AddWALInfoToBackupManifest(&manifest, startptr, starttli, endptr, endtli);
@@ -772,6 +774,8 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 	bool		o_noverify_checksums = false;
 	bool		o_manifest = false;
 	bool		o_manifest_checksums = false;
+	bool		o_compression = false;
+	bool		o_compression_level = false;
 
 	MemSet(opt, 0, sizeof(*opt));
 	opt->manifest = MANIFEST_OPTION_NO;
@@ -904,6 +908,30 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 								optval)));
 			o_manifest_checksums = true;
 		}
+		else if (strcmp(defel->defname, "compression") == 0)
+		{
+			char	   *optval = strVal(defel->arg);
+
+			if (o_compression)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			if (!ParseBackupCompressionType(optval, &opt->compression))
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("unrecognized or unsupported compression method: \"%s\"",
+								optval)));
+			o_compression = true;
+		}
+		else if (strcmp(defel->defname, "compression_level") == 0)
+		{
+			if (o_compression_level)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			opt->compression_level = intVal(defel->arg);
+			o_compression_level = true;
+		}
 		else
 			elog(ERROR, "option \"%s\" not recognized",
 				 defel->defname);
@@ -918,6 +946,26 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 					 errmsg("manifest checksums require a backup manifest")));
 		opt->manifest_checksum_type = CHECKSUM_TYPE_NONE;
 	}
+	if (o_compression_level)
+	{
+		int			maxlevel = 0;
+
+		if (!o_compression)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("COMPRESSION_LEVEL requires COMPRESSION")));
+
+		if (opt->compression == BACKUP_COMPRESSION_GZIP)
+			maxlevel = 9;
+		else if (opt->compression == BACKUP_COMPRESSION_LZ4)
+			maxlevel = 12;
+
+		if (opt->compression_level < 1 || opt->compression_level > maxlevel)
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("compression level %d is out of range for the selected compression method",
+							opt->compression_level)));
+	}
 }
 
 
@@ -946,7 +994,21 @@ SendBaseBackup(BaseBackupCmd *cmd)
 		set_ps_display(activitymsg);
 	}
 
-	perform_base_backup(&opt);
+	PG_TRY();
+	{
+		perform_base_backup(&opt);
+	}
+	PG_CATCH();
+	{
+		/* Don't leak the compressor's memory if we fail mid-stream */
+		if (compress_state != NULL)
+		{
+			AbortBackupCompression(compress_state);
+			compress_state = NULL;
+		}
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
 }
 
 static void
@@ -1089,6 +1151,62 @@ SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli)
 	pq_puttextmessage('C', "SELECT");
 }
 
+/*
+ * Start sending a tar stream: send a CopyOutResponse message, and set up
+ * compression of the stream if requested.
+ */
+static void
+begin_tar_stream(basebackup_options *opt)
+{
+	StringInfoData buf;
+
+	/* Send CopyOutResponse message */
+	pq_beginmessage(&buf, 'H');
+	pq_sendbyte(&buf, 0);		/* overall format */
+	pq_sendint16(&buf, 0);		/* natts */
+	pq_endmessage(&buf);
+
+	if (opt->compression != BACKUP_COMPRESSION_NONE)
+		compress_state = BeginBackupCompression(opt->compression,
+												opt->compression_level);
+}
+
+/*
+ * Send some data of the current tar stream, compressing it if requested.
+ */
+static void
+send_tar_data(const char *data, size_t len)
+{
+	if (compress_state != NULL)
+		BackupCompressData(compress_state, data, len);
+	else if (pq_putmessage('d', data, len))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+}
+
+/*
+ * Finish the current tar stream, and send a CopyDone message.
+ *
+ * An uncompressed stream is terminated by the client, which appends the two
+ * empty blocks tar requires at the end.  It can't do that to a compressed
+ * stream, so in that case we add them ourselves before ending compression.
+ */
+static void
+end_tar_stream(void)
+{
+	if (compress_state != NULL)
+	{
+		char		zerobuf[TAR_BLOCK_SIZE * 2];
+
+		MemSet(zerobuf, 0, sizeof(zerobuf));
+		BackupCompressData(compress_state, zerobuf, sizeof(zerobuf));
+		EndBackupCompression(compress_state);
+		compress_state = NULL;
+	}
+
+	pq_putemptymessage('c');	/* CopyDone */
+}
+
 /*
  * Inject a file with given name and content in the output tar stream.
  */
@@ -1125,7 +1243,7 @@ sendFileWithContent(const char *filename, const char *content,
 
 	_tarWriteHeader(filename, NULL, &statbuf, false);
 	/* Send the contents as a CopyData message */
-	pq_putmessage('d', content, len);
+	send_tar_data(content, len);
 	update_basebackup_progress(len);
 
 	/* Pad to a multiple of the tar block size. */
@@ -1135,7 +1253,7 @@ sendFileWithContent(const char *filename, const char *content,
 		char		buf[TAR_BLOCK_SIZE];
 
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_tar_data(buf, pad);
 		update_basebackup_progress(pad);
 	}
 
@@ -1766,9 +1884,7 @@ sendFile(const char *readfilename, const char *tarfilename,
 		}
 
 		/* Send the chunk as a CopyData message */
-		if (pq_putmessage('d', buf, cnt))
-			ereport(ERROR,
-					(errmsg("base backup could not send data, aborting backup")));
+		send_tar_data(buf, cnt);
 		update_basebackup_progress(cnt);
 
 		/* Also feed it to the checksum machinery. */
@@ -1786,7 +1902,7 @@ sendFile(const char *readfilename, const char *tarfilename,
 		while (len < statbuf->st_size)
 		{
 			cnt = Min(sizeof(buf), statbuf->st_size - len);
-			pq_putmessage('d', buf, cnt);
+			send_tar_data(buf, cnt);
 			if (pg_checksum_update(&checksum_ctx, (uint8 *) buf, cnt) < 0)
 				elog(ERROR, "could not update checksum of base backup");
 			update_basebackup_progress(cnt);
@@ -1804,7 +1920,7 @@ sendFile(const char *readfilename, const char *tarfilename,
 	if (pad > 0)
 	{
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_tar_data(buf, pad);
 		update_basebackup_progress(pad);
 	}
 
@@ -1862,7 +1978,7 @@ _tarWriteHeader(const char *filename, const char *linktarget,
 				elog(ERROR, "unrecognized tar error: %d", rc);
 		}
 
-		pq_putmessage('d', h, sizeof(h));
+		send_tar_data(h, sizeof(h));
 		update_basebackup_progress(sizeof(h));
 	}
 
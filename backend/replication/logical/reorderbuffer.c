@@ -83,6 +83,9 @@
 
 #include <unistd.h>
 #include <sys/stat.h>
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
 
 #include "access/detoast.h"
 #include "access/heapam.h"
@@ -91,6 +94,7 @@
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "catalog/catalog.h"
+#include "common/pg_lzcompress.h"
 #include "lib/binaryheap.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -137,6 +141,10 @@ typedef struct TXNEntryFile
 	File		vfd;			/* -1 when the file is closed */
 	off_t		curOffset;		/* offset for next write or read. Reset to 0
 								 * when vfd is opened. */
+	char	   *block;			/* decompressed contents of current block */
+	Size		blocksize;		/* allocated size of block */
+	Size		blocklen;		/* valid bytes in block */
+	Size		blockpos;		/* offset of next change within block */
 } TXNEntryFile;
 
 /* k-way in-order change iteration support structures */
@@ -178,6 +186,22 @@ typedef struct ReorderBufferDiskChange
 	/* data follows */
 } ReorderBufferDiskChange;
 
+/*
+ * Serialized changes are not written to the spill files one by one, but
+ * collected into blocks of about SPILL_BLOCK_SIZE bytes, which are then
+ * compressed according to logical_decoding_spill_compression and written out
+ * with a single write.  Each block on disk starts with this header.  A change
+ * larger than SPILL_BLOCK_SIZE gets a block of its own.
+ */
+typedef struct ReorderBufferDiskBlock
+{
+	Size		rawsize;		/* length of the serialized changes */
+	Size		disksize;		/* length of the data following the header */
+	int			compression;	/* ReorderBufferSpillCompression method */
+} ReorderBufferDiskBlock;
+
+#define SPILL_BLOCK_SIZE	(4 * BLCKSZ)
+
 #define IsSpecInsert(action) \
 ( \
 	((action) == REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT) \
@@ -207,6 +231,7 @@ typedef struct ReorderBufferDiskChange
  * like.
  */
 int			logical_decoding_work_mem;
+int			logical_decoding_spill_compression = SPILL_COMPRESSION_NONE;
 static const Size max_changes_in_memory = 4096; /* XXX for restore only */
 
 /* ---------------------------------------
@@ -247,6 +272,9 @@ static void ReorderBufferCheckMemoryLimit(ReorderBuffer *rb);
 static void ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 										 int fd, ReorderBufferChange *change);
+static void ReorderBufferSerializeFlush(ReorderBuffer *rb, ReorderBufferTXN *txn,
+										int fd);
+static bool ReorderBufferRestoreBlock(ReorderBuffer *rb, TXNEntryFile *file);
 static Size ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 										TXNEntryFile *file, XLogSegNo *segno);
 static void ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
@@ -344,6 +372,11 @@ ReorderBufferAllocate(void)
 
 	buffer->outbuf = NULL;
 	buffer->outbufsize = 0;
+	buffer->spillbuf = NULL;
+	buffer->spillbufsize = 0;
+	buffer->spillbuflen = 0;
+	buffer->compbuf = NULL;
+	buffer->compbufsize = 0;
 	buffer->size = 0;
 
 	buffer->spillTxns = 0;
@@ -1425,6 +1458,8 @@ ReorderBufferIterTXNFinish(ReorderBuffer *rb,
 	{
 		if (state->entries[off].file.vfd != -1)
 			FileClose(state->entries[off].file.vfd);
+		if (state->entries[off].file.block != NULL)
+			pfree(state->entries[off].file.block);
 	}
 
 	/* free memory we might have "leaked" in the last *Next call */
@@ -3332,23 +3367,33 @@ ReorderBufferXidHasBaseSnapshot(ReorderBuffer *rb, TransactionId xid)
  */
 
 /*
- * Ensure the IO buffer is >= sz.
+ * Ensure the buffer *buf, currently *bufsize bytes large, is >= sz.
  */
 static void
-ReorderBufferSerializeReserve(ReorderBuffer *rb, Size sz)
+ReorderBufferReserveBuffer(ReorderBuffer *rb, char **buf, Size *bufsize,
+						   Size sz)
 {
-	if (!rb->outbufsize)
+	if (!*bufsize)
 	{
-		rb->outbuf = MemoryContextAlloc(rb->context, sz);
-		rb->outbufsize = sz;
+		*buf = MemoryContextAlloc(rb->context, sz);
+		*bufsize = sz;
 	}
-	else if (rb->outbufsize < sz)
+	else if (*bufsize < sz)
 	{
-		rb->outbuf = repalloc(rb->outbuf, sz);
-		rb->outbufsize = sz;
+		*buf = repalloc(*buf, sz);
+		*bufsize = sz;
 	}
 }
 
+/*
+ * Ensure the IO buffer is >= sz.
+ */
+static void
+ReorderBufferSerializeReserve(ReorderBuffer *rb, Size sz)
+{
+	ReorderBufferReserveBuffer(rb, &rb->outbuf, &rb->outbufsize, sz);
+}
+
 /*
  * Find the largest transaction (toplevel or subxact) to evict (spill to disk).
  *
@@ -3525,6 +3570,9 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	elog(DEBUG2, "spill %u changes in XID %u to disk",
 		 (uint32) txn->nentries_mem, txn->xid);
 
+	/* any block left over from an earlier, failed attempt is useless */
+	rb->spillbuflen = 0;
+
 	/* do the same to all child TXs */
 	dlist_foreach(subtxn_i, &txn->subtxns)
 	{
@@ -3551,7 +3599,10 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 			char		path[MAXPGPATH];
 
 			if (fd != -1)
+			{
+				ReorderBufferSerializeFlush(rb, txn, fd);
 				CloseTransientFile(fd);
+			}
 
 			XLByteToSeg(change->lsn, curOpenSegNo, wal_segment_size);
 
@@ -3598,7 +3649,10 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	txn->txn_flags |= RBTXN_IS_SERIALIZED;
 
 	if (fd != -1)
+	{
+		ReorderBufferSerializeFlush(rb, txn, fd);
 		CloseTransientFile(fd);
+	}
 }
 
 /*
@@ -3787,9 +3841,103 @@ ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 	ondisk->size = sz;
 
+	/*
+	 * Add the change to the pending block, writing out the block first if
+	 * the change doesn't fit anymore.
+	 */
+	if (rb->spillbuflen > 0 && rb->spillbuflen + sz > SPILL_BLOCK_SIZE)
+		ReorderBufferSerializeFlush(rb, txn, fd);
+
+	ReorderBufferReserveBuffer(rb, &rb->spillbuf, &rb->spillbufsize,
+							   sizeof(ReorderBufferDiskBlock) +
+							   Max(rb->spillbuflen + sz, SPILL_BLOCK_SIZE));
+	memcpy(rb->spillbuf + sizeof(ReorderBufferDiskBlock) + rb->spillbuflen,
+		   rb->outbuf, sz);
+	rb->spillbuflen += sz;
+
+	/*
+	 * Keep the transaction's final_lsn up to date with each change we send to
+	 * disk, so that ReorderBufferRestoreCleanup works correctly.  (We used to
+	 * only do this on commit and abort records, but that doesn't work if a
+	 * system crash leaves a transaction without its abort record).
+	 *
+	 * Make sure not to move it backwards.
+	 */
+	if (txn->final_lsn < change->lsn)
+		txn->final_lsn = change->lsn;
+
+	Assert(ondisk->change.action == change->action);
+}
+
+/*
+ * Write out the pending block of serialized changes, compressing it first if
+ * logical_decoding_spill_compression says so.
+ */
+static void
+ReorderBufferSerializeFlush(ReorderBuffer *rb, ReorderBufferTXN *txn, int fd)
+{
+	ReorderBufferDiskBlock *block;
+	char	   *raw;
+	Size		rawsize = rb->spillbuflen;
+	int32		complen = -1;
+
+	if (rawsize == 0)
+		return;
+
+	raw = rb->spillbuf + sizeof(ReorderBufferDiskBlock);
+
+	switch ((ReorderBufferSpillCompression) logical_decoding_spill_compression)
+	{
+		case SPILL_COMPRESSION_NONE:
+			break;
+
+		case SPILL_COMPRESSION_PGLZ:
+			ReorderBufferReserveBuffer(rb, &rb->compbuf, &rb->compbufsize,
+									   sizeof(ReorderBufferDiskBlock) +
+									   PGLZ_MAX_OUTPUT(rawsize));
+			complen = pglz_compress(raw, rawsize,
+									rb->compbuf + sizeof(ReorderBufferDiskBlock),
+									PGLZ_strategy_default);
+			break;
+
+		case SPILL_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			ReorderBufferReserveBuffer(rb, &rb->compbuf, &rb->compbufsize,
+									   sizeof(ReorderBufferDiskBlock) +
+									   LZ4_compressBound(rawsize));
+			complen = LZ4_compress_default(raw,
+										   rb->compbuf + sizeof(ReorderBufferDiskBlock),
+										   rawsize, LZ4_compressBound(rawsize));
+			if (complen <= 0)
+				complen = -1;	/* failure */
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+	}
+
+	/* store the block uncompressed if compression didn't pay off */
+	if (complen >= 0 && complen < rawsize)
+	{
+		block = (ReorderBufferDiskBlock *) rb->compbuf;
+		block->compression = logical_decoding_spill_compression;
+		block->disksize = complen;
+	}
+	else
+	{
+		block = (ReorderBufferDiskBlock *) rb->spillbuf;
+		block->compression = SPILL_COMPRESSION_NONE;
+		block->disksize = rawsize;
+	}
+	block->rawsize = rawsize;
+
+	/* the pending block is gone, whatever happens below */
+	rb->spillbuflen = 0;
+
 	errno = 0;
 	pgstat_report_wait_start(WAIT_EVENT_REORDER_BUFFER_WRITE);
-	if (write(fd, rb->outbuf, ondisk->size) != ondisk->size)
+	if (write(fd, block, sizeof(ReorderBufferDiskBlock) + block->disksize) !=
+		sizeof(ReorderBufferDiskBlock) + block->disksize)
 	{
 		int			save_errno = errno;
 
@@ -3803,19 +3951,6 @@ ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 						txn->xid)));
 	}
 	pgstat_report_wait_end();
-
-	/*
-	 * Keep the transaction's final_lsn up to date with each change we send to
-	 * disk, so that ReorderBufferRestoreCleanup works correctly.  (We used to
-	 * only do this on commit and abort records, but that doesn't work if a
-	 * system crash leaves a transaction without its abort record).
-	 *
-	 * Make sure not to move it backwards.
-	 */
-	if (txn->final_lsn < change->lsn)
-		txn->final_lsn = change->lsn;
-
-	Assert(ondisk->change.action == change->action);
 }
 
 /* Returns true, if the output plugin supports streaming, false, otherwise. */
@@ -4084,8 +4219,7 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 	while (restored < max_changes_in_memory && *segno <= last_segno)
 	{
-		int			readBytes;
-		ReorderBufferDiskChange *ondisk;
+		Size		size;
 
 		if (*fd == -1)
 		{
@@ -4106,8 +4240,10 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 			*fd = PathNameOpenFile(path, O_RDONLY | PG_BINARY);
 
-			/* No harm in resetting the offset even in case of failure */
+			/* No harm in resetting the offsets even in case of failure */
 			file->curOffset = 0;
+			file->blocklen = 0;
+			file->blockpos = 0;
 
 			if (*fd < 0 && errno == ENOENT)
 			{
@@ -4123,60 +4259,38 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 		}
 
 		/*
-		 * Read the statically sized part of a change which has information
-		 * about the total size. If we couldn't read a record, we're at the
-		 * end of this file.
+		 * Read the next block of changes once the current one is used up. If
+		 * there is none, we're at the end of this file.
 		 */
-		ReorderBufferSerializeReserve(rb, sizeof(ReorderBufferDiskChange));
-		readBytes = FileRead(file->vfd, rb->outbuf,
-							 sizeof(ReorderBufferDiskChange),
-							 file->curOffset, WAIT_EVENT_REORDER_BUFFER_READ);
-
-		/* eof */
-		if (readBytes == 0)
+		if (file->blockpos >= file->blocklen &&
+			!ReorderBufferRestoreBlock(rb, file))
 		{
 			FileClose(*fd);
 			*fd = -1;
 			(*segno)++;
 			continue;
 		}
-		else if (readBytes < 0)
-			ereport(ERROR,
-					(errcode_for_file_access(),
-					 errmsg("could not read from reorderbuffer spill file: %m")));
-		else if (readBytes != sizeof(ReorderBufferDiskChange))
-			ereport(ERROR,
-					(errcode_for_file_access(),
-					 errmsg("could not read from reorderbuffer spill file: read %d instead of %u bytes",
-							readBytes,
-							(uint32) sizeof(ReorderBufferDiskChange))));
-
-		file->curOffset += readBytes;
 
-		ondisk = (ReorderBufferDiskChange *) rb->outbuf;
-
-		ReorderBufferSerializeReserve(rb,
-									  sizeof(ReorderBufferDiskChange) + ondisk->size);
-		ondisk = (ReorderBufferDiskChange *) rb->outbuf;
-
-		readBytes = FileRead(file->vfd,
-							 rb->outbuf + sizeof(ReorderBufferDiskChange),
-							 ondisk->size - sizeof(ReorderBufferDiskChange),
-							 file->curOffset,
-							 WAIT_EVENT_REORDER_BUFFER_READ);
-
-		if (readBytes < 0)
+		/*
+		 * Changes are packed without alignment padding within a block, so
+		 * copy the change into the (suitably aligned) IO buffer.
+		 */
+		if (file->blocklen - file->blockpos < sizeof(ReorderBufferDiskChange))
 			ereport(ERROR,
-					(errcode_for_file_access(),
-					 errmsg("could not read from reorderbuffer spill file: %m")));
-		else if (readBytes != ondisk->size - sizeof(ReorderBufferDiskChange))
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("truncated change in reorderbuffer spill file")));
+		memcpy(&size, file->block + file->blockpos +
+			   offsetof(ReorderBufferDiskChange, size), sizeof(Size));
+		if (size < sizeof(ReorderBufferDiskChange) ||
+			size > file->blocklen - file->blockpos)
 			ereport(ERROR,
-					(errcode_for_file_access(),
-					 errmsg("could not read from reorderbuffer spill file: read %d instead of %u bytes",
-							readBytes,
-							(uint32) (ondisk->size - sizeof(ReorderBufferDiskChange)))));
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("invalid change of size %zu in reorderbuffer spill file",
+							size)));
 
-		file->curOffset += readBytes;
+		ReorderBufferSerializeReserve(rb, size);
+		memcpy(rb->outbuf, file->block + file->blockpos, size);
+		file->blockpos += size;
 
 		/*
 		 * ok, read a full change from disk, now restore it into proper
@@ -4189,6 +4303,118 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	return restored;
 }
 
+/*
+ * Read the next block of spilled changes from the file, and decompress it into
+ * file->block.  Returns false at the end of the file.
+ */
+static bool
+ReorderBufferRestoreBlock(ReorderBuffer *rb, TXNEntryFile *file)
+{
+	ReorderBufferDiskBlock header;
+	char	   *dest;
+	int			readBytes;
+
+	readBytes = FileRead(file->vfd, (char *) &header,
+						 sizeof(ReorderBufferDiskBlock),
+						 file->curOffset, WAIT_EVENT_REORDER_BUFFER_READ);
+
+	/* eof */
+	if (readBytes == 0)
+		return false;
+	else if (readBytes < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: %m")));
+	else if (readBytes != sizeof(ReorderBufferDiskBlock))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: read %d instead of %u bytes",
+						readBytes,
+						(uint32) sizeof(ReorderBufferDiskBlock))));
+
+	file->curOffset += readBytes;
+
+	if (header.rawsize == 0 || header.rawsize > MaxAllocSize ||
+		header.disksize > MaxAllocSize ||
+		(header.compression == SPILL_COMPRESSION_NONE &&
+		 header.disksize != header.rawsize))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid block header in reorderbuffer spill file")));
+
+	if (file->blocksize < header.rawsize)
+	{
+		if (file->block != NULL)
+			pfree(file->block);
+		file->block = MemoryContextAlloc(rb->context,
+										 Max(header.rawsize, SPILL_BLOCK_SIZE));
+		file->blocksize = Max(header.rawsize, SPILL_BLOCK_SIZE);
+	}
+
+	/* compressed data goes to the IO buffer first */
+	if (header.compression == SPILL_COMPRESSION_NONE)
+		dest = file->block;
+	else
+	{
+		ReorderBufferSerializeReserve(rb, header.disksize);
+		dest = rb->outbuf;
+	}
+
+	readBytes = FileRead(file->vfd, dest, header.disksize, file->curOffset,
+						 WAIT_EVENT_REORDER_BUFFER_READ);
+
+	if (readBytes < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: %m")));
+	else if (readBytes != header.disksize)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: read %d instead of %u bytes",
+						readBytes,
+						(uint32) header.disksize)));
+
+	file->curOffset += readBytes;
+
+	switch (header.compression)
+	{
+		case SPILL_COMPRESSION_NONE:
+			break;
+
+		case SPILL_COMPRESSION_PGLZ:
+			if (pglz_decompress(rb->outbuf, header.disksize, file->block,
+								header.rawsize, true) != header.rawsize)
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("compressed block in reorderbuffer spill file is corrupted")));
+			break;
+
+		case SPILL_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			if (LZ4_decompress_safe(rb->outbuf, file->block,
+									header.disksize, header.rawsize) !=
+				header.rawsize)
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("compressed block in reorderbuffer spill file is corrupted")));
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("invalid compression method %d in reorderbuffer spill file",
+							header.compression)));
+	}
+
+	file->blocklen = header.rawsize;
+	file->blockpos = 0;
+
+	return true;
+}
+
 /*
  * Convert change from its on-disk format to in-memory format and queue it onto
  * the TXN's ->changes list.
@@ -500,6 +500,7 @@ SnapBuildBuildSnapshot(SnapBuild *builder)
 	snapshot->subxip = NULL;
 
 	snapshot->suboverflowed = false;
+	snapshot->subxoverflow_xmin = snapshot->xmin;
 	snapshot->takenDuringRecovery = false;
 	snapshot->copied = false;
 	snapshot->curcid = FirstCommandId;
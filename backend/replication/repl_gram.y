@@ -86,6 +86,8 @@ Node *replication_parse_result;
 %token K_USE_SNAPSHOT
 %token K_MANIFEST
 %token K_MANIFEST_CHECKSUMS
+%token K_COMPRESSION
+%token K_COMPRESSION_LEVEL
 
 %type <node>	command
 %type <node>	base_backup start_replication start_logical_replication
@@ -223,6 +225,16 @@ base_backup_opt:
 				  $$ = makeDefElem("manifest_checksums",
 								   (Node *)makeString($2), -1);
 				}
+			| K_COMPRESSION SCONST
+				{
+				  $$ = makeDefElem("compression",
+								   (Node *)makeString($2), -1);
+				}
+			| K_COMPRESSION_LEVEL UCONST
+				{
+				  $$ = makeDefElem("compression_level",
+								   (Node *)makeInteger($2), -1);
+				}
 			;
 
 create_replication_slot:
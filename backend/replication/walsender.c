@@ -158,6 +158,14 @@ static StringInfoData output_message;
 static StringInfoData reply_message;
 static StringInfoData tmpbuf;
 
+/*
+ * Segment that a WAL data message sent straight from its file was taken
+ * from, while we still have to check that it wasn't removed before the
+ * send completed.  sendFileSegNo is 0 if there is no such message.
+ */
+static XLogSegNo sendFileSegNo = 0;
+static TimeLineID sendFileTLI = 0;
+
 /* Timestamp of last ProcessRepliesIfAny(). */
 static TimestampTz last_processing = 0;
 
@@ -256,6 +264,9 @@ static bool TransactionIdInRecentPast(TransactionId xid, uint32 epoch);
 
 static void WalSndSegmentOpen(XLogReaderState *state, XLogSegNo nextSegNo,
 							  TimeLineID *tli_p);
+static void WalSndOpenSegmentFor(XLogRecPtr ptr);
+static void WalSndFillSendTime(void);
+static void WalSndCheckSentFile(void);
 
 
 /* Initialize walsender process before entering the main command loop */
@@ -2348,6 +2359,8 @@ WalSndLoop(WalSndSendDataCallback send_data)
 		if (pq_flush_if_writable() != 0)
 			WalSndShutdown();
 
+		WalSndCheckSentFile();
+
 		/* If nothing remains to be sent right now ... */
 		if (WalSndCaughtUp && !pq_is_send_pending())
 		{
@@ -2384,6 +2397,9 @@ WalSndLoop(WalSndSendDataCallback send_data)
 		/* Send keepalive if the time has come */
 		WalSndKeepaliveIfNecessary();
 
+		/* We don't go through pgstat_report_stat(), so send these here */
+		pgstat_send_lwlock(false);
+
 		/*
 		 * Block if we have unsent data.  XXX For logical replication, let
 		 * WalSndWaitForWal() handle any other blocking; idle receivers need
@@ -2495,6 +2511,58 @@ WalSndKill(int code, Datum arg)
 	SpinLockRelease(&walsnd->mutex);
 }
 
+/*
+ * Make sure the WAL segment containing ptr is open in xlogreader, opening it
+ * the same way WALRead() would.
+ */
+static void
+WalSndOpenSegmentFor(XLogRecPtr ptr)
+{
+	XLogSegNo	segno;
+	TimeLineID	tli = xlogreader->seg.ws_tli;
+
+	if (xlogreader->seg.ws_file >= 0 &&
+		XLByteInSeg(ptr, xlogreader->seg.ws_segno,
+					xlogreader->segcxt.ws_segsize))
+		return;
+
+	if (xlogreader->seg.ws_file >= 0)
+		wal_segment_close(xlogreader);
+
+	XLByteToSeg(ptr, segno, xlogreader->segcxt.ws_segsize);
+	WalSndSegmentOpen(xlogreader, segno, &tli);
+
+	xlogreader->seg.ws_tli = tli;
+	xlogreader->seg.ws_segno = segno;
+}
+
+/*
+ * Fill in the send timestamp of the WAL data message in output_message.
+ */
+static void
+WalSndFillSendTime(void)
+{
+	resetStringInfo(&tmpbuf);
+	pq_sendint64(&tmpbuf, GetCurrentTimestamp());
+	memcpy(&output_message.data[1 + sizeof(int64) + sizeof(int64)],
+		   tmpbuf.data, sizeof(int64));
+}
+
+/*
+ * Once a WAL data message sent from the segment file has gone out entirely,
+ * check that the segment wasn't removed or recycled meanwhile, the same way
+ * we check after reading it with WALRead().
+ */
+static void
+WalSndCheckSentFile(void)
+{
+	if (sendFileSegNo == 0 || pq_is_send_pending())
+		return;
+
+	CheckXLogRemoved(sendFileSegNo, sendFileTLI);
+	sendFileSegNo = 0;
+}
+
 /* XLogReaderRoutine->segment_open callback */
 static void
 WalSndSegmentOpen(XLogReaderState *state, XLogSegNo nextSegNo,
@@ -2583,6 +2651,11 @@ XLogSendPhysical(void)
 	Size		nbytes;
 	XLogSegNo	segno;
 	WALReadError errinfo;
+	bool		sent_from_file = false;
+	XLogRecPtr	restart_lsn = InvalidXLogRecPtr;
+
+	/* Our previous message must have been sent from intact WAL */
+	WalSndCheckSentFile();
 
 	/* If requested switch the WAL sender to the stopping state. */
 	if (got_STOPPING)
@@ -2793,62 +2866,103 @@ XLogSendPhysical(void)
 	pq_sendint64(&output_message, 0);	/* sendtime, filled in last */
 
 	/*
-	 * Read the log directly into the output buffer to avoid extra memcpy
-	 * calls.
+	 * If the WAL is protected from removal by a replication slot, try to have
+	 * it sent straight from the segment file, saving the copies through our
+	 * buffers.  The slot only protects it if its restart_lsn is not past
+	 * startptr, and only if max_slot_wal_keep_size can't invalidate the slot
+	 * while the data is waiting to go out; the standby would write whatever
+	 * the recycled segment then contains into its pg_wal before learning
+	 * about the removal.  This is not possible if the slice spans two
+	 * segments, and not safe for a cascading walsender, whose segment files
+	 * might be replaced with files restored from the archive.
+	 * WalSndCheckSentFile() still repeats the removal check once the message
+	 * has been sent, as WALRead() callers do after reading.
 	 */
-	enlargeStringInfo(&output_message, nbytes);
-
-retry:
-	if (!WALRead(xlogreader,
-				 &output_message.data[output_message.len],
-				 startptr,
-				 nbytes,
-				 xlogreader->seg.ws_tli,	/* Pass the current TLI because
-											 * only WalSndSegmentOpen controls
-											 * whether new TLI is needed. */
-				 &errinfo))
-		WALReadRaiseError(&errinfo);
+	if (MyReplicationSlot != NULL)
+	{
+		SpinLockAcquire(&MyReplicationSlot->mutex);
+		restart_lsn = MyReplicationSlot->data.restart_lsn;
+		SpinLockRelease(&MyReplicationSlot->mutex);
+	}
 
-	/* See logical_read_xlog_page(). */
 	XLByteToSeg(startptr, segno, xlogreader->segcxt.ws_segsize);
-	CheckXLogRemoved(segno, xlogreader->seg.ws_tli);
+	if (!XLogRecPtrIsInvalid(restart_lsn) && restart_lsn <= startptr &&
+		max_slot_wal_keep_size_mb == -1 && !am_cascading_walsender &&
+		XLByteInSeg(endptr - 1, segno, xlogreader->segcxt.ws_segsize))
+	{
+		WalSndOpenSegmentFor(startptr);
+		CheckXLogRemoved(segno, xlogreader->seg.ws_tli);
+
+		WalSndFillSendTime();
+		sent_from_file =
+			pq_putmessage_file_noblock('d', output_message.data,
+									   output_message.len,
+									   xlogreader->seg.ws_file,
+									   XLogSegmentOffset(startptr, xlogreader->segcxt.ws_segsize),
+									   nbytes);
+		if (sent_from_file)
+		{
+			sendFileSegNo = segno;
+			sendFileTLI = xlogreader->seg.ws_tli;
+		}
+	}
 
-	/*
-	 * During recovery, the currently-open WAL file might be replaced with the
-	 * file of the same name retrieved from archive. So we always need to
-	 * check what we read was valid after reading into the buffer. If it's
-	 * invalid, we try to open and read the file again.
-	 */
-	if (am_cascading_walsender)
+	if (!sent_from_file)
 	{
-		WalSnd	   *walsnd = MyWalSnd;
-		bool		reload;
+		/*
+		 * Read the log directly into the output buffer to avoid extra memcpy
+		 * calls.
+		 */
+		enlargeStringInfo(&output_message, nbytes);
 
-		SpinLockAcquire(&walsnd->mutex);
-		reload = walsnd->needreload;
-		walsnd->needreload = false;
-		SpinLockRelease(&walsnd->mutex);
+retry:
+		if (!WALRead(xlogreader,
+					 &output_message.data[output_message.len],
+					 startptr,
+					 nbytes,
+					 xlogreader->seg.ws_tli,	/* Pass the current TLI
+												 * because only
+												 * WalSndSegmentOpen controls
+												 * whether new TLI is needed. */
+					 &errinfo))
+			WALReadRaiseError(&errinfo);
+
+		/* See logical_read_xlog_page(). */
+		XLByteToSeg(startptr, segno, xlogreader->segcxt.ws_segsize);
+		CheckXLogRemoved(segno, xlogreader->seg.ws_tli);
 
-		if (reload && xlogreader->seg.ws_file >= 0)
+		/*
+		 * During recovery, the currently-open WAL file might be replaced with
+		 * the file of the same name retrieved from archive. So we always need
+		 * to check what we read was valid after reading into the buffer. If
+		 * it's invalid, we try to open and read the file again.
+		 */
+		if (am_cascading_walsender)
 		{
-			wal_segment_close(xlogreader);
+			WalSnd	   *walsnd = MyWalSnd;
+			bool		reload;
+
+			SpinLockAcquire(&walsnd->mutex);
+			reload = walsnd->needreload;
+			walsnd->needreload = false;
+			SpinLockRelease(&walsnd->mutex);
+
+			if (reload && xlogreader->seg.ws_file >= 0)
+			{
+				wal_segment_close(xlogreader);
 
-			goto retry;
+				goto retry;
+			}
 		}
-	}
 
-	output_message.len += nbytes;
-	output_message.data[output_message.len] = '\0';
+		output_message.len += nbytes;
+		output_message.data[output_message.len] = '\0';
 
-	/*
-	 * Fill the send timestamp last, so that it is taken as late as possible.
-	 */
-	resetStringInfo(&tmpbuf);
-	pq_sendint64(&tmpbuf, GetCurrentTimestamp());
-	memcpy(&output_message.data[1 + sizeof(int64) + sizeof(int64)],
-		   tmpbuf.data, sizeof(int64));
+		/* Fill the send timestamp last, so that it's as late as possible. */
+		WalSndFillSendTime();
 
-	pq_putmessage_noblock('d', output_message.data, output_message.len);
+		pq_putmessage_noblock('d', output_message.data, output_message.len);
+	}
 
 	sentPtr = endptr;
 
@@ -9,6 +9,11 @@
  * in most cases the caller needs to adjust the buffer header contents
  * before the lock is released (see notes in README).
  *
+ * Besides the dynahash table, which is the authoritative mapping, we keep
+ * an open-addressing index that can be probed without any lock at all; see
+ * BufTableLookupNoLock().  The index is maintained by BufTableInsert() and
+ * BufTableDelete() under the same partition locks as the hash table.
+ *
  *
  * Portions Copyright (c) 1996-2021, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -21,6 +26,7 @@
  */
 #include "postgres.h"
 
+#include "port/pg_bitutils.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
 
@@ -33,6 +39,55 @@ typedef struct
 
 static HTAB *SharedBufHash;
 
+/*
+ * Lock-free lookup index.
+ *
+ * The index is an array of slots divided into NUM_BUFFER_PARTITIONS equally
+ * sized regions, one per buffer mapping partition.  A tag whose hash code
+ * falls in a given partition is only ever stored in that partition's region
+ * (using linear probing that wraps around within the region), so all changes
+ * to a region are serialized by the partition's BufMappingLock held in
+ * exclusive mode.  Readers take no lock at all.
+ *
+ * Each slot holds the tag's hash code in the high 32 bits and buffer ID + 1
+ * in the low 32 bits; zero means the slot is empty.  Since a slot can be
+ * read and written atomically, a reader never sees a half-written entry, but
+ * it may see a stale one, or miss an entry that is being moved by a
+ * concurrent deletion.  Hence a hit is only a hint that must be verified
+ * against the buffer header after pinning the buffer, and a miss must be
+ * confirmed with BufTableLookup() under the partition lock.
+ *
+ * Since the hash code of every entry is stored in its slot, deletion can use
+ * backward-shift instead of tombstones, so probe sequences never grow beyond
+ * what the current contents require.  If a region becomes three-quarters
+ * full, further entries are simply not indexed; lookups for them will then
+ * fall back to the hash table.  That should only ever happen if the hash
+ * codes of the cached pages are very unevenly distributed.
+ */
+typedef struct BufTableIndex
+{
+	/* number of slots in use in each region, protected by BufMappingLock */
+	uint32		nused[NUM_BUFFER_PARTITIONS];
+
+	pg_atomic_uint64 slots[FLEXIBLE_ARRAY_MEMBER];
+} BufTableIndex;
+
+#define BufTableIndexEntry(hashcode, buf_id) \
+	(((uint64) (hashcode) << 32) | (uint64) ((buf_id) + 1))
+#define BufTableIndexEntryHash(entry)	((uint32) ((entry) >> 32))
+#define BufTableIndexEntryBufId(entry)	((int) ((uint32) (entry)) - 1)
+
+static BufTableIndex *SharedBufIndex;
+
+/* number of slots in each region; always a power of 2 */
+static uint32 BufTableIndexRegionSize;
+
+static uint32 BufTableIndexSlotsPerRegion(int size);
+static inline pg_atomic_uint64 *BufTableIndexRegion(uint32 hashcode);
+static inline uint32 BufTableIndexHome(uint32 hashcode);
+static void BufTableIndexInsert(uint32 hashcode, int buf_id);
+static void BufTableIndexDelete(uint32 hashcode, int buf_id);
+
 
 /*
  * Estimate space needed for mapping hashtable
@@ -41,7 +96,17 @@ static HTAB *SharedBufHash;
 Size
 BufTableShmemSize(int size)
 {
-	return hash_estimate_size(size, sizeof(BufferLookupEnt));
+	Size		sz;
+
+	sz = hash_estimate_size(size, sizeof(BufferLookupEnt));
+
+	/* lock-free lookup index */
+	sz = add_size(sz, offsetof(BufTableIndex, slots));
+	sz = add_size(sz, mul_size(mul_size(BufTableIndexSlotsPerRegion(size),
+										NUM_BUFFER_PARTITIONS),
+							   sizeof(pg_atomic_uint64)));
+
+	return sz;
 }
 
 /*
@@ -52,6 +117,8 @@ void
 InitBufTable(int size)
 {
 	HASHCTL		info;
+	uint32		nslots;
+	bool		found;
 
 	/* assume no locking is needed yet */
 
@@ -64,6 +131,61 @@ InitBufTable(int size)
 								  size, size,
 								  &info,
 								  HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+
+	/* ... and the lock-free lookup index */
+	BufTableIndexRegionSize = BufTableIndexSlotsPerRegion(size);
+	nslots = BufTableIndexRegionSize * NUM_BUFFER_PARTITIONS;
+
+	SharedBufIndex = (BufTableIndex *)
+		ShmemInitStruct("Shared Buffer Lookup Index",
+						offsetof(BufTableIndex, slots) +
+						nslots * sizeof(pg_atomic_uint64),
+						&found);
+
+	if (!found)
+	{
+		uint32		i;
+
+		memset(SharedBufIndex->nused, 0, sizeof(SharedBufIndex->nused));
+		for (i = 0; i < nslots; i++)
+			pg_atomic_init_u64(&SharedBufIndex->slots[i], 0);
+	}
+}
+
+/*
+ * Compute the number of lock-free index slots per partition region for a
+ * mapping table of the given size.  We aim for a fill factor of at most 50%
+ * on average, so that probe sequences stay short even when the hash codes
+ * don't spread perfectly evenly across partitions.
+ */
+static uint32
+BufTableIndexSlotsPerRegion(int size)
+{
+	uint32		nslots;
+
+	nslots = (uint32) (2 * (size / NUM_BUFFER_PARTITIONS + 1));
+
+	return pg_nextpower2_32(Max(nslots, 16));
+}
+
+/*
+ * Return the first slot of the index region that hashcode belongs to.
+ */
+static inline pg_atomic_uint64 *
+BufTableIndexRegion(uint32 hashcode)
+{
+	return &SharedBufIndex->slots[BufTableHashPartition(hashcode) *
+								  BufTableIndexRegionSize];
+}
+
+/*
+ * Return the preferred position of hashcode within its index region.  The
+ * low-order bits already determine the partition, so use the others.
+ */
+static inline uint32
+BufTableIndexHome(uint32 hashcode)
+{
+	return (hashcode / NUM_BUFFER_PARTITIONS) & (BufTableIndexRegionSize - 1);
 }
 
 /*
@@ -105,6 +227,51 @@ BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 	return result->id;
 }
 
+/*
+ * BufTableLookupNoLock
+ *		Lookup the given BufferTag in the lock-free index; return a buffer
+ *		ID that may hold the page, or -1 if none was found
+ *
+ * No lock is required.  The result is only a hint: the caller must pin the
+ * buffer and then verify that it still holds the requested tag.  Also, -1
+ * doesn't prove that the page isn't in the buffer pool, so the caller must
+ * confirm that with BufTableLookup() before loading the page.
+ */
+int
+BufTableLookupNoLock(BufferTag *tagPtr, uint32 hashcode)
+{
+	pg_atomic_uint64 *region = BufTableIndexRegion(hashcode);
+	uint32		mask = BufTableIndexRegionSize - 1;
+	uint32		pos = BufTableIndexHome(hashcode);
+	uint32		i;
+
+	for (i = 0; i < BufTableIndexRegionSize; i++)
+	{
+		uint64		entry = pg_atomic_read_u64(&region[pos]);
+
+		if (entry == 0)
+			break;
+
+		if (BufTableIndexEntryHash(entry) == hashcode)
+		{
+			int			buf_id = BufTableIndexEntryBufId(entry);
+			BufferDesc *buf = GetBufferDescriptor(buf_id);
+
+			/*
+			 * Check the tag without holding the buffer header lock, to skip
+			 * over hash collisions.  We might read a torn or outdated tag
+			 * here, but the caller rechecks after pinning.
+			 */
+			if (BUFFERTAGS_EQUAL(buf->tag, *tagPtr))
+				return buf_id;
+		}
+
+		pos = (pos + 1) & mask;
+	}
+
+	return -1;
+}
+
 /*
  * BufTableInsert
  *		Insert a hashtable entry for given tag and buffer ID,
@@ -136,6 +303,8 @@ BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 
 	result->id = buf_id;
 
+	BufTableIndexInsert(hashcode, buf_id);
+
 	return -1;
 }
 
@@ -159,4 +328,92 @@ BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
 
 	if (!result)				/* shouldn't happen */
 		elog(ERROR, "shared buffer hash table corrupted");
+
+	BufTableIndexDelete(hashcode, result->id);
+}
+
+/*
+ * BufTableIndexInsert
+ *		Add an entry for given hash code and buffer ID to the lock-free index
+ *
+ * Caller must hold exclusive lock on BufMappingLock for hashcode's partition
+ */
+static void
+BufTableIndexInsert(uint32 hashcode, int buf_id)
+{
+	uint32		partition = BufTableHashPartition(hashcode);
+	pg_atomic_uint64 *region = BufTableIndexRegion(hashcode);
+	uint32		mask = BufTableIndexRegionSize - 1;
+	uint32		pos = BufTableIndexHome(hashcode);
+
+	/*
+	 * If the region is getting full, leave the entry out.  Lookups for it
+	 * will miss and fall back to the hash table, which is still correct.
+	 */
+	if (SharedBufIndex->nused[partition] >=
+		BufTableIndexRegionSize - BufTableIndexRegionSize / 4)
+		return;
+
+	while (pg_atomic_read_u64(&region[pos]) != 0)
+		pos = (pos + 1) & mask;
+
+	pg_atomic_write_u64(&region[pos], BufTableIndexEntry(hashcode, buf_id));
+	SharedBufIndex->nused[partition]++;
+}
+
+/*
+ * BufTableIndexDelete
+ *		Remove the entry for given hash code and buffer ID from the lock-free
+ *		index, if it's there
+ *
+ * Caller must hold exclusive lock on BufMappingLock for hashcode's partition
+ */
+static void
+BufTableIndexDelete(uint32 hashcode, int buf_id)
+{
+	uint32		partition = BufTableHashPartition(hashcode);
+	pg_atomic_uint64 *region = BufTableIndexRegion(hashcode);
+	uint32		mask = BufTableIndexRegionSize - 1;
+	uint32		pos = BufTableIndexHome(hashcode);
+	uint64		target = BufTableIndexEntry(hashcode, buf_id);
+	uint64		entry;
+	uint32		next;
+
+	/* Find the entry; it's not there if the region was full at insertion */
+	for (;;)
+	{
+		entry = pg_atomic_read_u64(&region[pos]);
+		if (entry == 0)
+			return;
+		if (entry == target)
+			break;
+		pos = (pos + 1) & mask;
+	}
+
+	/*
+	 * Close the gap by moving back any following entries of the same probe
+	 * run that would otherwise become unreachable from their home position.
+	 * An entry is copied into the gap before its old slot is reused, so a
+	 * concurrent reader can at worst miss it, never find a wrong one.  The
+	 * loop terminates because a region is never completely full.
+	 */
+	for (next = (pos + 1) & mask;; next = (next + 1) & mask)
+	{
+		uint32		home;
+
+		entry = pg_atomic_read_u64(&region[next]);
+		if (entry == 0)
+			break;
+
+		/* Move it unless its home lies cyclically in (pos, next] */
+		home = BufTableIndexHome(BufTableIndexEntryHash(entry));
+		if (((next - home) & mask) >= ((next - pos) & mask))
+		{
+			pg_atomic_write_u64(&region[pos], entry);
+			pos = next;
+		}
+	}
+
+	pg_atomic_write_u64(&region[pos], 0);
+	SharedBufIndex->nused[partition]--;
 }
@@ -517,10 +517,18 @@ PrefetchSharedBuffer(SMgrRelation smgr_reln,
 	newHash = BufTableHashCode(&newTag);
 	newPartitionLock = BufMappingPartitionLock(newHash);
 
-	/* see if the block is in the buffer pool already */
-	LWLockAcquire(newPartitionLock, LW_SHARED);
-	buf_id = BufTableLookup(&newTag, newHash);
-	LWLockRelease(newPartitionLock);
+	/*
+	 * See if the block is in the buffer pool already.  A hit in the lock-free
+	 * index is good enough for us, since the caller has to recheck anyway,
+	 * but a miss needs to be confirmed under the mapping lock.
+	 */
+	buf_id = BufTableLookupNoLock(&newTag, newHash);
+	if (buf_id < 0)
+	{
+		LWLockAcquire(newPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&newTag, newHash);
+		LWLockRelease(newPartitionLock);
+	}
 
 	/* If not in buffers, initiate prefetch */
 	if (buf_id < 0)
@@ -1128,23 +1136,57 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	newHash = BufTableHashCode(&newTag);
 	newPartitionLock = BufMappingPartitionLock(newHash);
 
-	/* see if the block is in the buffer pool already */
-	LWLockAcquire(newPartitionLock, LW_SHARED);
-	buf_id = BufTableLookup(&newTag, newHash);
+	/*
+	 * See if the block is in the buffer pool already.  First try the
+	 * lock-free lookup index.  What it returns is only a hint, so we must pin
+	 * the buffer and then check that it really holds the requested page.
+	 * Once we have it pinned, nobody can change its tag, so the check needs
+	 * no lock.  If the buffer was reassigned in the meantime, drop the pin
+	 * again; such a fleeting pin of an unrelated buffer is harmless, and
+	 * this only happens when we race with eviction of the very buffer the
+	 * index pointed to.
+	 */
+	buf_id = BufTableLookupNoLock(&newTag, newHash);
 	if (buf_id >= 0)
 	{
-		/*
-		 * Found it.  Now, pin the buffer so no one can steal it from the
-		 * buffer pool, and check to see if the correct data has been loaded
-		 * into the buffer.
-		 */
 		buf = GetBufferDescriptor(buf_id);
 
 		valid = PinBuffer(buf, strategy);
 
+		buf_state = pg_atomic_read_u32(&buf->state);
+		if (!(buf_state & BM_TAG_VALID) || !BUFFERTAGS_EQUAL(buf->tag, newTag))
+		{
+			UnpinBuffer(buf, true);
+			buf_id = -1;
+		}
+	}
+
+	/* If that failed, do a regular lookup under the mapping lock */
+	if (buf_id < 0)
+	{
+		LWLockAcquire(newPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&newTag, newHash);
+		if (buf_id >= 0)
+		{
+			/*
+			 * Found it.  Now, pin the buffer so no one can steal it from the
+			 * buffer pool.
+			 */
+			buf = GetBufferDescriptor(buf_id);
+
+			valid = PinBuffer(buf, strategy);
+		}
+
 		/* Can release the mapping lock as soon as we've pinned it */
 		LWLockRelease(newPartitionLock);
+	}
 
+	if (buf_id >= 0)
+	{
+		/*
+		 * Found it, and it's pinned.  Check to see if the correct data has
+		 * been loaded into the buffer.
+		 */
 		*foundPtr = true;
 
 		if (!valid)
@@ -1171,9 +1213,8 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 	/*
 	 * Didn't find it in the buffer pool.  We'll have to initialize a new
-	 * buffer.  Remember to unlock the mapping lock while doing the work.
+	 * buffer.
 	 */
-	LWLockRelease(newPartitionLock);
 
 	/* Loop here in case we have to try another victim buffer */
 	for (;;)
@@ -2991,6 +3032,76 @@ RelationGetNumberOfBlocksInFork(Relation relation, ForkNumber forkNum)
 	return 0;					/* keep compiler quiet */
 }
 
+/*
+ * ExtendRelationBulk
+ *		Extends the specified relation fork by nblocks blocks at once.
+ *
+ * The new blocks are zero-filled on disk (or just allocated, where the file
+ * system can do that), but unlike ReadBuffer(P_NEW) they are not loaded into
+ * any buffer; whoever reads them first sees new, all-zero pages.  This makes
+ * it much cheaper than calling ReadBuffer(P_NEW) nblocks times.  Returns the
+ * block number of the first new block.
+ *
+ * As with P_NEW, the caller is responsible for ensuring that only one
+ * backend tries to extend a relation at the same time.  Relations using local
+ * buffers are not supported; they never need bulk extension, since no other
+ * backend competes for their extension.
+ */
+BlockNumber
+ExtendRelationBulk(Relation relation, ForkNumber forkNum, int nblocks)
+{
+	BlockNumber firstBlock;
+
+	Assert(nblocks > 0);
+	Assert(!RelationUsesLocalBuffers(relation));
+
+	/* Open it at the smgr level if not already done */
+	RelationOpenSmgr(relation);
+
+	/* see comments in ReadBufferExtended */
+	if (RELATION_IS_OTHER_TEMP(relation))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot access temporary tables of other sessions")));
+
+	firstBlock = smgrnblocks(relation->rd_smgr, forkNum);
+
+	/*
+	 * Since the new blocks don't go through shared buffers, a buffer left
+	 * behind for one of them would later be returned instead of the zeroed
+	 * page on disk.  ReadBuffer(P_NEW) checks for such buffers too; see the
+	 * comments there about how they can come about.  Unlike P_NEW, we don't
+	 * look at the buffer's contents, and simply refuse to extend.
+	 */
+	for (int i = 0; i < nblocks; i++)
+	{
+		BufferTag	tag;
+		uint32		hash;
+		LWLock	   *partitionLock;
+		int			buf_id;
+
+		INIT_BUFFERTAG(tag, relation->rd_smgr->smgr_rnode.node,
+					   forkNum, firstBlock + i);
+		hash = BufTableHashCode(&tag);
+		partitionLock = BufMappingPartitionLock(hash);
+
+		LWLockAcquire(partitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&tag, hash);
+		LWLockRelease(partitionLock);
+
+		if (buf_id >= 0)
+			ereport(ERROR,
+					(errmsg("unexpected data beyond EOF in block %u of relation %s",
+							firstBlock + i,
+							relpath(relation->rd_smgr->smgr_rnode, forkNum)),
+					 errhint("This has been seen to occur with buggy kernels; consider updating your system.")));
+	}
+
+	smgrzeroextend(relation->rd_smgr, forkNum, firstBlock, nblocks, false);
+
+	return firstBlock;
+}
+
 /*
  * BufferIsPermanent
  *		Determines whether a buffer will potentially still be around after
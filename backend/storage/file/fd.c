@@ -2176,6 +2176,130 @@ retry:
 	return returnCode;
 }
 
+/*
+ * FileZero - write zeroes into a range of the file, extending it if needed.
+ *
+ * Returns 0 on success, -1 otherwise.  In the latter case errno is set to
+ * the appropriate error, as with FileWrite.  This is not meant for temporary
+ * files, so temp_file_limit is not enforced.
+ */
+int
+FileZero(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+	static const PGAlignedBlock zbuffer = {{0}};	/* worth BLCKSZ */
+	struct iovec iov[PG_IOV_MAX];
+	int			returnCode;
+	int			i;
+
+	Assert(FileIsValid(file));
+	Assert(!(VfdCache[file].fdstate & FD_TEMP_FILE_LIMIT));
+
+	DO_DB(elog(LOG, "FileZero: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	/* Every iovec points to the same block of zeroes */
+	for (i = 0; i < PG_IOV_MAX; i++)
+	{
+		iov[i].iov_base = unconstify(char *, &zbuffer.data[0]);
+		iov[i].iov_len = BLCKSZ;
+	}
+
+	while (amount > 0)
+	{
+		int			iovcnt = 0;
+		off_t		chunk = 0;
+		ssize_t		written;
+
+		while (iovcnt < PG_IOV_MAX && chunk < amount)
+		{
+			iov[iovcnt].iov_len = Min(amount - chunk, BLCKSZ);
+			chunk += iov[iovcnt].iov_len;
+			iovcnt++;
+		}
+
+		errno = 0;
+		pgstat_report_wait_start(wait_event_info);
+		written = pg_pwritev(VfdCache[file].fd, iov, iovcnt, offset);
+		pgstat_report_wait_end();
+
+		/* restore the iovecs we may have shortened */
+		iov[iovcnt - 1].iov_len = BLCKSZ;
+
+		if (written < 0)
+		{
+			/* OK to retry if interrupted */
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (written == 0)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			if (errno == 0)
+				errno = ENOSPC;
+			return -1;
+		}
+
+		offset += written;
+		amount -= written;
+	}
+
+	return 0;
+}
+
+/*
+ * FileFallocate - allocate space for a range of the file, extending it if
+ * needed.  The new space reads as zeroes.
+ *
+ * Where the file system supports it, this avoids actually writing out the
+ * zeroes, which makes it much cheaper than FileZero for large ranges.
+ * Returns 0 on success, -1 otherwise, with errno set.
+ */
+int
+FileFallocate(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+#ifdef HAVE_POSIX_FALLOCATE
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileFallocate: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return -1;
+
+retry:
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = posix_fallocate(VfdCache[file].fd, offset, amount);
+	pgstat_report_wait_end();
+
+	if (returnCode == 0)
+		return 0;
+	else if (returnCode == EINTR)
+		goto retry;
+
+	/* for compatibility with %m printing etc */
+	errno = returnCode;
+
+	/*
+	 * Return in cases of a "real" failure.  If fallocate is not supported by
+	 * the file system, fall through to writing the zeroes ourselves.
+	 */
+	if (returnCode != EINVAL && returnCode != EOPNOTSUPP)
+		return -1;
+#endif
+
+	return FileZero(file, offset, amount, wait_event_info);
+}
+
 int
 FileSync(File file, uint32 wait_event_info)
 {
@@ -20,6 +20,7 @@
 #include "storage/copydir.h"
 #include "storage/fd.h"
 #include "storage/reinit.h"
+#include "storage/relsize.h"
 #include "utils/hsearch.h"
 #include "utils/memutils.h"
 
@@ -88,6 +89,12 @@ ResetUnloggedRelations(int op)
 
 	FreeDir(spc_dir);
 
+	/*
+	 * We've removed or overwritten relation files without going through
+	 * smgr.c, so discard any sizes it might have cached for them.
+	 */
+	RelSizeCacheForgetAll();
+
 	/*
 	 * Restore memory context.
 	 */
@@ -190,6 +190,53 @@ RecordPageWithFreeSpace(Relation rel, BlockNumber heapBlk, Size spaceAvail)
 	fsm_set_and_search(rel, addr, slot, new_cat, 0);
 }
 
+/*
+ * RecordPageRangeWithFreeSpace - like RecordPageWithFreeSpace, for all heap
+ *		blocks in the range [start, end)
+ *
+ * This is meant for registering a batch of newly added pages at once.  Each
+ * FSM leaf page covering the range is locked only once.  The same caveat
+ * about upper level pages applies as for RecordPageWithFreeSpace.
+ */
+void
+RecordPageRangeWithFreeSpace(Relation rel, BlockNumber start, BlockNumber end,
+							 Size spaceAvail)
+{
+	int			new_cat = fsm_space_avail_to_cat(spaceAvail);
+	BlockNumber heapBlk = start;
+
+	while (heapBlk < end)
+	{
+		FSMAddress	addr;
+		uint16		slot;
+		Buffer		buf;
+		Page		page;
+		bool		modified = false;
+
+		/* Get the location of the FSM byte representing the heap block */
+		addr = fsm_get_location(heapBlk, &slot);
+
+		buf = fsm_readbuf(rel, addr, true);
+		LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+
+		page = BufferGetPage(buf);
+
+		/* Set all the slots on this FSM page that fall in the range */
+		do
+		{
+			if (fsm_set_avail(page, slot, new_cat))
+				modified = true;
+			heapBlk++;
+			slot++;
+		} while (heapBlk < end && slot < SlotsPerFSMPage);
+
+		if (modified)
+			MarkBufferDirtyHint(buf, false);
+
+		UnlockReleaseBuffer(buf);
+	}
+}
+
 /*
  * XLogRecordPageWithFreeSpace - like RecordPageWithFreeSpace, for use in
  *		WAL replay
@@ -68,6 +68,7 @@
 #include "postmaster/postmaster.h"
 #include "storage/dsm_impl.h"
 #include "storage/fd.h"
+#include "storage/pg_shmem.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
 
@@ -75,7 +76,8 @@
 static bool dsm_impl_posix(dsm_op op, dsm_handle handle, Size request_size,
 						   void **impl_private, void **mapped_address,
 						   Size *mapped_size, int elevel);
-static int	dsm_impl_posix_resize(int fd, off_t size);
+static void dsm_impl_posix_advise(char *address, Size size, bool create);
+static int	dsm_impl_posix_allocate(int fd, off_t size);
 #endif
 #ifdef USE_DSM_SYSV
 static bool dsm_impl_sysv(dsm_op op, dsm_handle handle, Size request_size,
@@ -295,7 +297,7 @@ dsm_impl_posix(dsm_op op, dsm_handle handle, Size request_size,
 		}
 		request_size = st.st_size;
 	}
-	else if (dsm_impl_posix_resize(fd, request_size) != 0)
+	else if (ftruncate(fd, request_size) != 0)
 	{
 		int			save_errno;
 
@@ -342,6 +344,40 @@ dsm_impl_posix(dsm_op op, dsm_handle handle, Size request_size,
 						name)));
 		return false;
 	}
+
+	/*
+	 * Set up huge page and NUMA policies for the mapping.  When creating the
+	 * segment, this has to happen before any memory is allocated to it.
+	 */
+	dsm_impl_posix_advise(address, request_size, op == DSM_OP_CREATE);
+
+	if (op == DSM_OP_CREATE && dsm_impl_posix_allocate(fd, request_size) != 0)
+	{
+		int			save_errno;
+
+		/* Back out what's already been done. */
+		save_errno = errno;
+		munmap(address, request_size);
+		close(fd);
+		ReleaseExternalFD();
+		shm_unlink(name);
+		errno = save_errno;
+
+		/*
+		 * If we received a query cancel or termination signal, we will have
+		 * EINTR set here.  If the caller said that errors are OK here, check
+		 * for interrupts immediately.
+		 */
+		if (errno == EINTR && elevel >= ERROR)
+			CHECK_FOR_INTERRUPTS();
+
+		ereport(elevel,
+				(errcode_for_dynamic_shared_memory(),
+				 errmsg("could not resize shared memory segment \"%s\" to %zu bytes: %m",
+						name, request_size)));
+		return false;
+	}
+
 	*mapped_address = address;
 	*mapped_size = request_size;
 	close(fd);
@@ -351,19 +387,45 @@ dsm_impl_posix(dsm_op op, dsm_handle handle, Size request_size,
 }
 
 /*
- * Set the size of a virtual memory region associated with a file descriptor.
- * If necessary, also ensure that virtual memory is actually allocated by the
- * operating system, to avoid nasty surprises later.
+ * Request huge pages and NUMA placement for a freshly mapped segment.
+ *
+ * On Linux, POSIX shared memory lives in tmpfs, which can back a mapping
+ * with transparent huge pages when the mapping is marked MADV_HUGEPAGE
+ * (depending on /sys/kernel/mm/transparent_hugepage/shmem_enabled).  We do
+ * that whenever huge_pages isn't "off".  Parallel hash joins and the like
+ * access DSA memory randomly, so they benefit from fewer TLB misses just as
+ * much as accesses to the main shared memory segment do.  Unlike for the main
+ * segment, we can't tell whether huge pages will actually be used, so
+ * huge_pages = on doesn't make failure to get them an error here.
  *
- * Returns non-zero if either truncation or allocation fails, and sets errno.
+ * The NUMA policy belongs to the underlying shared memory object, so it only
+ * needs to be set by the process creating the segment.  Both settings are
+ * advisory, so failures are ignored.
  */
-static int
-dsm_impl_posix_resize(int fd, off_t size)
+static void
+dsm_impl_posix_advise(char *address, Size size, bool create)
 {
-	int			rc;
+#ifdef MADV_HUGEPAGE
+	if (huge_pages != HUGE_PAGES_OFF)
+		(void) madvise(address, size, MADV_HUGEPAGE);
+#endif
+
+	if (create)
+		PGSharedMemoryInterleave(address, size, DEBUG1);
+}
 
-	/* Truncate (or extend) the file to the requested size. */
-	rc = ftruncate(fd, size);
+/*
+ * Ensure that virtual memory for a newly sized segment is actually allocated
+ * by the operating system, to avoid nasty surprises later.  The caller must
+ * already have set the size with ftruncate, and mapped the segment and set
+ * its memory policies, so that the allocated pages respect those policies.
+ *
+ * Returns non-zero if allocation fails, and sets errno.
+ */
+static int
+dsm_impl_posix_allocate(int fd, off_t size)
+{
+	int			rc = 0;
 
 	/*
 	 * On Linux, a shm_open fd is backed by a tmpfs file.  After resizing with
@@ -374,27 +436,24 @@ dsm_impl_posix_resize(int fd, off_t size)
 	 * SIGBUS later.
 	 */
 #if defined(HAVE_POSIX_FALLOCATE) && defined(__linux__)
-	if (rc == 0)
+	/*
+	 * We may get interrupted.  If so, just retry unless there is an
+	 * interrupt pending.  This avoids the possibility of looping forever
+	 * if another backend is repeatedly trying to interrupt us.
+	 */
+	pgstat_report_wait_start(WAIT_EVENT_DSM_FILL_ZERO_WRITE);
+	do
 	{
-		/*
-		 * We may get interrupted.  If so, just retry unless there is an
-		 * interrupt pending.  This avoids the possibility of looping forever
-		 * if another backend is repeatedly trying to interrupt us.
-		 */
-		pgstat_report_wait_start(WAIT_EVENT_DSM_FILL_ZERO_WRITE);
-		do
-		{
-			rc = posix_fallocate(fd, 0, size);
-		} while (rc == EINTR && !(ProcDiePending || QueryCancelPending));
-		pgstat_report_wait_end();
+		rc = posix_fallocate(fd, 0, size);
+	} while (rc == EINTR && !(ProcDiePending || QueryCancelPending));
+	pgstat_report_wait_end();
 
-		/*
-		 * The caller expects errno to be set, but posix_fallocate() doesn't
-		 * set it.  Instead it returns error numbers directly.  So set errno,
-		 * even though we'll also return rc to indicate success or failure.
-		 */
-		errno = rc;
-	}
+	/*
+	 * The caller expects errno to be set, but posix_fallocate() doesn't
+	 * set it.  Instead it returns error numbers directly.  So set errno,
+	 * even though we'll also return rc to indicate success or failure.
+	 */
+	errno = rc;
 #endif							/* HAVE_POSIX_FALLOCATE && __linux__ */
 
 	return rc;
@@ -25,6 +25,7 @@
 #include "commands/async.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "postmaster/autoprewarm.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
@@ -43,6 +44,7 @@
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "storage/procsignal.h"
+#include "storage/relsize.h"
 #include "storage/sinvaladt.h"
 #include "storage/spin.h"
 #include "utils/snapmgr.h"
@@ -122,6 +124,7 @@ CreateSharedMemoryAndSemaphores(void)
 												 sizeof(ShmemIndexEnt)));
 		size = add_size(size, dsm_estimate_size());
 		size = add_size(size, BufferShmemSize());
+		size = add_size(size, RelSizeShmemSize());
 		size = add_size(size, LockShmemSize());
 		size = add_size(size, PredicateLockShmemSize());
 		size = add_size(size, ProcGlobalShmemSize());
@@ -146,6 +149,7 @@ CreateSharedMemoryAndSemaphores(void)
 		size = add_size(size, WalRcvShmemSize());
 		size = add_size(size, PgArchShmemSize());
 		size = add_size(size, ApplyLauncherShmemSize());
+		size = add_size(size, AutoPrewarmShmemSize());
 		size = add_size(size, SnapMgrShmemSize());
 		size = add_size(size, BTreeShmemSize());
 		size = add_size(size, SyncScanShmemSize());
@@ -222,6 +226,7 @@ CreateSharedMemoryAndSemaphores(void)
 	SUBTRANSShmemInit();
 	MultiXactShmemInit();
 	InitBufferPool();
+	RelSizeShmemInit();
 
 	/*
 	 * Set up lock manager
@@ -261,6 +266,7 @@ CreateSharedMemoryAndSemaphores(void)
 	WalRcvShmemInit();
 	PgArchShmemInit();
 	ApplyLauncherShmemInit();
+	AutoPrewarmShmemInit();
 
 	/*
 	 * Set up other modules that need some shared memory space
@@ -64,7 +64,10 @@
  * work. That's problematic because we're now stuck waiting inside the OS.
 
  * To mitigate those races we use a two phased attempt at locking:
- *	 Phase 1: Try to do it atomically, if we succeed, nice
+ *	 Phase 1: Try to do it atomically, if we succeed, nice.  If the lock
+ *			  is busy but nobody is queued for it yet, spin a bounded
+ *			  number of times re-checking it, since the holder is likely
+ *			  to release it before we could even go to sleep
  *	 Phase 2: Add ourselves to the waitqueue of the lock
  *	 Phase 3: Try to grab the lock again, if we succeed, remove ourselves from
  *			  the queue
@@ -107,6 +110,16 @@ extern slock_t *ShmemLock;
 /* Must be greater than MAX_BACKENDS - which is 2^23-1, so we're fine. */
 #define LW_SHARED_MASK				((uint32) ((1 << 24)-1))
 
+/*
+ * Number of times LWLockAcquire re-checks a busy lock before queueing itself
+ * and going to sleep.  See LWLockSpinAcquire().
+ */
+#define LWLOCK_SPINS_MAX			64
+
+/* Index into PendingLWLockStats[] for a lock */
+#define LWLockStatsIndex(lock) \
+	Min((lock)->tranche, LWTRANCHE_FIRST_USER_DEFINED)
+
 /*
  * There are three sorts of LWLock "tranches":
  *
@@ -175,7 +188,13 @@ static const char *const BuiltinTrancheNames[] = {
 	/* LWTRANCHE_PARALLEL_APPEND: */
 	"ParallelAppend",
 	/* LWTRANCHE_PER_XACT_PREDICATE_LIST: */
-	"PerXactPredicateList"
+	"PerXactPredicateList",
+	/* LWTRANCHE_RELSIZE_CACHE: */
+	"RelSizeCache",
+	/* LWTRANCHE_SUBTRANS_SLRU: */
+	"SubtransSLRU",
+	/* LWTRANCHE_MULTIXACTOFFSET_SLRU: */
+	"MultiXactOffsetSLRU"
 };
 
 StaticAssertDecl(lengthof(BuiltinTrancheNames) ==
@@ -241,6 +260,7 @@ static bool lock_named_request_allowed = true;
 static void InitializeLWLocks(void);
 static inline void LWLockReportWaitStart(LWLock *lock);
 static inline void LWLockReportWaitEnd(void);
+static inline void LWLockCountWait(LWLock *lock, instr_time *wait_start);
 static const char *GetLWTrancheName(uint16 trancheId);
 
 #define T_NAME(lock) \
@@ -769,6 +789,23 @@ LWLockReportWaitEnd(void)
 	pgstat_report_wait_end();
 }
 
+/*
+ * Account for having slept on the lock since wait_start, in the statistics
+ * sent to the stats collector.
+ */
+static inline void
+LWLockCountWait(LWLock *lock, instr_time *wait_start)
+{
+	PgStat_LWLockEntry *entry = &PendingLWLockStats[LWLockStatsIndex(lock)];
+	instr_time	wait_time;
+
+	INSTR_TIME_SET_CURRENT(wait_time);
+	INSTR_TIME_SUBTRACT(wait_time, *wait_start);
+
+	entry->t_waits++;
+	entry->t_wait_time += INSTR_TIME_GET_MICROSEC(wait_time);
+}
+
 /*
  * Return the name of an LWLock tranche.
  */
@@ -797,6 +834,21 @@ GetLWTrancheName(uint16 trancheId)
 	return LWLockTrancheNames[trancheId];
 }
 
+/*
+ * Return the name shown for an entry of the LWLock statistics.
+ */
+const char *
+GetLWLockStatsTrancheName(int index)
+{
+	Assert(index >= 0 && index < NUM_LWLOCK_STATS_TRANCHES);
+
+	/* all extension tranches are lumped together */
+	if (index >= LWTRANCHE_FIRST_USER_DEFINED)
+		return "extension";
+
+	return GetLWTrancheName(index);
+}
+
 /*
  * Return an identifier for an LWLock based on the wait class and event.
  */
@@ -880,6 +932,55 @@ LWLockAttemptLock(LWLock *lock, LWLockMode mode)
 	pg_unreachable();
 }
 
+/*
+ * Wait a little for a busy lock to become free, without going to sleep.
+ *
+ * Handing a contended lock over through the wait queue costs a semaphore
+ * wakeup, and a context switch for the waiter, which is usually a lot more
+ * than the holder spends inside the short critical sections LWLocks protect.
+ * So before queueing ourselves, re-check the lock a bounded number of times
+ * and grab it if it looks free.  This only reads the lock word until it
+ * looks free, so spinners don't bounce its cache line around any more than
+ * the waiters already do.
+ *
+ * We don't spin if anyone is already queued for the lock: that means it's
+ * not being released quickly, and we'd only be overtaking the waiters.
+ *
+ * Returns true if we acquired the lock.
+ */
+static bool
+LWLockSpinAcquire(LWLock *lock, LWLockMode mode)
+{
+	PgStat_LWLockEntry *entry = &PendingLWLockStats[LWLockStatsIndex(lock)];
+	int			spins;
+
+	for (spins = 1; spins <= LWLOCK_SPINS_MAX; spins++)
+	{
+		uint32		state;
+		bool		lock_free;
+
+		pg_spin_delay();
+
+		state = pg_atomic_read_u32(&lock->state);
+		if (state & LW_FLAG_HAS_WAITERS)
+			break;
+
+		if (mode == LW_EXCLUSIVE)
+			lock_free = (state & LW_LOCK_MASK) == 0;
+		else
+			lock_free = (state & LW_VAL_EXCLUSIVE) == 0;
+
+		if (lock_free && !LWLockAttemptLock(lock, mode))
+		{
+			entry->t_spins += spins;
+			return true;
+		}
+	}
+
+	entry->t_spins += spins - 1;
+	return false;
+}
+
 /*
  * Lock the LWLock's wait list against concurrent activity.
  *
@@ -1205,6 +1306,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 	PGPROC	   *proc = MyProc;
 	bool		result = true;
 	int			extraWaits = 0;
+	instr_time	wait_start;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1215,6 +1317,8 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 
 	PRINT_LWDEBUG("LWLockAcquire", lock, mode);
 
+	PendingLWLockStats[LWLockStatsIndex(lock)].t_acquisitions++;
+
 #ifdef LWLOCK_STATS
 	/* Count lock acquisition attempts */
 	if (mode == LW_EXCLUSIVE)
@@ -1273,6 +1377,13 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 			break;				/* got the lock */
 		}
 
+		/* Spin for a bit, in case the holder is about to release it */
+		if (LWLockSpinAcquire(lock, mode))
+		{
+			LOG_LWDEBUG("LWLockAcquire", lock, "acquired after spinning");
+			break;
+		}
+
 		/*
 		 * Ok, at this point we couldn't grab the lock on the first try. We
 		 * cannot simply queue ourselves to the end of the list and wait to be
@@ -1317,6 +1428,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 		if (TRACE_POSTGRESQL_LWLOCK_WAIT_START_ENABLED())
 			TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), mode);
 
+		INSTR_TIME_SET_CURRENT(wait_start);
 		for (;;)
 		{
 			PGSemaphoreLock(proc->sem);
@@ -1324,6 +1436,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 				break;
 			extraWaits++;
 		}
+		LWLockCountWait(lock, &wait_start);
 
 		/* Retrying, allow LWLockRelease to release waiters again. */
 		pg_atomic_fetch_or_u32(&lock->state, LW_FLAG_RELEASE_OK);
@@ -1379,6 +1492,8 @@ LWLockConditionalAcquire(LWLock *lock, LWLockMode mode)
 
 	PRINT_LWDEBUG("LWLockConditionalAcquire", lock, mode);
 
+	PendingLWLockStats[LWLockStatsIndex(lock)].t_acquisitions++;
+
 	/* Ensure we will have room to remember the lock */
 	if (num_held_lwlocks >= MAX_SIMUL_LWLOCKS)
 		elog(ERROR, "too many LWLocks taken");
@@ -1433,6 +1548,7 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 	PGPROC	   *proc = MyProc;
 	bool		mustwait;
 	int			extraWaits = 0;
+	instr_time	wait_start;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1443,6 +1559,8 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 
 	PRINT_LWDEBUG("LWLockAcquireOrWait", lock, mode);
 
+	PendingLWLockStats[LWLockStatsIndex(lock)].t_acquisitions++;
+
 	/* Ensure we will have room to remember the lock */
 	if (num_held_lwlocks >= MAX_SIMUL_LWLOCKS)
 		elog(ERROR, "too many LWLocks taken");
@@ -1482,6 +1600,7 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 			if (TRACE_POSTGRESQL_LWLOCK_WAIT_START_ENABLED())
 				TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), mode);
 
+			INSTR_TIME_SET_CURRENT(wait_start);
 			for (;;)
 			{
 				PGSemaphoreLock(proc->sem);
@@ -1489,6 +1608,7 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 					break;
 				extraWaits++;
 			}
+			LWLockCountWait(lock, &wait_start);
 
 #ifdef LOCK_DEBUG
 			{
@@ -1620,6 +1740,7 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 	PGPROC	   *proc = MyProc;
 	int			extraWaits = 0;
 	bool		result = false;
+	instr_time	wait_start;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1698,6 +1819,7 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 		if (TRACE_POSTGRESQL_LWLOCK_WAIT_START_ENABLED())
 			TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), LW_EXCLUSIVE);
 
+		INSTR_TIME_SET_CURRENT(wait_start);
 		for (;;)
 		{
 			PGSemaphoreLock(proc->sem);
@@ -1705,6 +1827,7 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 				break;
 			extraWaits++;
 		}
+		LWLockCountWait(lock, &wait_start);
 
 #ifdef LOCK_DEBUG
 		{
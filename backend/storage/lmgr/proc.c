@@ -95,6 +95,18 @@ static void AuxiliaryProcKill(int code, Datum arg);
 static void CheckDeadLock(void);
 
 
+/*
+ * Report shared-memory space needed for one PGPROC's fast-path lock arrays.
+ */
+static Size
+FastPathLockShmemPerProc(void)
+{
+	return add_size(MAXALIGN(mul_size(FastPathLockGroupsPerBackend,
+									  sizeof(uint64))),
+					MAXALIGN(mul_size(FastPathLockSlotsPerBackend(),
+									  sizeof(Oid))));
+}
+
 /*
  * Report shared-memory space needed by InitProcGlobal.
  */
@@ -114,6 +126,9 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(TotalProcs, sizeof(*ProcGlobal->subxidStates)));
 	size = add_size(size, mul_size(TotalProcs, sizeof(*ProcGlobal->statusFlags)));
 
+	/* fast-path lock arrays */
+	size = add_size(size, mul_size(TotalProcs, FastPathLockShmemPerProc()));
+
 	return size;
 }
 
@@ -163,6 +178,9 @@ InitProcGlobal(void)
 				j;
 	bool		found;
 	uint32		TotalProcs = MaxBackends + NUM_AUXILIARY_PROCS + max_prepared_xacts;
+	char	   *fpPtr;
+	Size		fpLockBitsSize,
+				fpRelIdSize;
 
 	/* Create the ProcGlobal shared structure */
 	ProcGlobal = (PROC_HDR *)
@@ -214,10 +232,27 @@ InitProcGlobal(void)
 	ProcGlobal->statusFlags = (uint8 *) ShmemAlloc(TotalProcs * sizeof(*ProcGlobal->statusFlags));
 	MemSet(ProcGlobal->statusFlags, 0, TotalProcs * sizeof(*ProcGlobal->statusFlags));
 
+	/*
+	 * Allocate the fast-path lock arrays of all the PGPROCs in one chunk.
+	 * Their size depends on max_locks_per_transaction, so they can't be
+	 * embedded in PGPROC itself.
+	 */
+	fpLockBitsSize = MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+	fpRelIdSize = MAXALIGN(FastPathLockSlotsPerBackend() * sizeof(Oid));
+
+	fpPtr = ShmemAlloc(TotalProcs * (fpLockBitsSize + fpRelIdSize));
+	MemSet(fpPtr, 0, TotalProcs * (fpLockBitsSize + fpRelIdSize));
+
 	for (i = 0; i < TotalProcs; i++)
 	{
 		/* Common initialization for all PGPROCs, regardless of type. */
 
+		/* Point the PGPROC at its share of the fast-path lock arrays. */
+		procs[i].fpLockBits = (uint64 *) fpPtr;
+		fpPtr += fpLockBitsSize;
+		procs[i].fpRelId = (Oid *) fpPtr;
+		fpPtr += fpRelIdSize;
+
 		/*
 		 * Set up per-PGPROC semaphore, latch, and fpInfoLock.  Prepared xact
 		 * dummy PGPROCs don't need these though - they're never associated
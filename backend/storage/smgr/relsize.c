@@ -0,0 +1,469 @@
+/*-------------------------------------------------------------------------
+ *
+ * relsize.c
+ *	  shared cache of relation fork sizes
+ *
+ * Finding out the size of a relation fork with md.c requires opening every
+ * segment file of the fork and calling lseek() on the last one.  Sequential
+ * scans, the planner, relation extension and many other places ask for the
+ * size of relations all the time, and with many large relations that means a
+ * lot of system calls, as well as a lot of churn in fd.c's VFD cache since
+ * segments that we'll never read are opened just to be skipped over.
+ *
+ * To avoid that, we remember the sizes of relation forks in a hash table in
+ * shared memory.  smgr.c consults the table before asking the storage
+ * manager, and keeps it up to date whenever it extends, truncates, creates or
+ * unlinks a fork.  Temporary relations are never entered, since they are
+ * only accessed by their owning backend.
+ *
+ * Extension is by far the most common size change, so it must be cheap.  If
+ * the fork already has an entry, extending it only takes the partition lock
+ * in shared mode and advances the size with a compare-and-swap that never
+ * moves it backwards.  Exclusive locks are needed only to add or remove
+ * entries, and for truncation.
+ *
+ * The tricky part is filling the cache from the storage manager.  A backend
+ * that looked up a fork, found nothing, and then asked the kernel for its
+ * size could race with another backend changing the size of the fork, and
+ * overwrite the newer size with its stale value.  That would be disastrous,
+ * since new pages would then be placed on top of existing ones.  An
+ * extension that finds no entry creates one, which makes the stale insertion
+ * a no-op.  For the remaining cases, each partition of the table has a
+ * generation counter that is advanced by truncations, removals, and
+ * extensions that could not be recorded for lack of space.  Lookups report
+ * the counter, and the size obtained afterwards is only entered if the
+ * counter hasn't moved in the meantime.
+ *
+ * The table has a fixed maximum size, set by relsize_cache_entries.  When it
+ * is full, further forks are simply not cached; we don't try to evict
+ * anything.  Entries go away when their relation or database is dropped.
+ *
+ * Anything that changes the size of relation files behind smgr.c's back must
+ * discard the affected entries.  Currently that's only the copying of init
+ * forks at the end of recovery, and dropping or moving whole databases.
+ *
+ *
+ * Portions Copyright (c) 1996-2021, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/smgr/relsize.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "port/atomics.h"
+#include "storage/lwlock.h"
+#include "storage/relsize.h"
+#include "storage/shmem.h"
+#include "utils/hsearch.h"
+
+/* GUC variable */
+int			relsize_cache_entries = 16384;
+
+/* Number of partitions of the relation size table */
+#define NUM_RELSIZE_PARTITIONS	16
+
+/* Hash table key */
+typedef struct RelSizeTag
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+} RelSizeTag;
+
+/* Hash table entry */
+typedef struct RelSizeEnt
+{
+	RelSizeTag	tag;			/* hash key; must be first */
+	pg_atomic_uint32 nblocks;	/* size of the fork */
+} RelSizeEnt;
+
+typedef struct RelSizeCtlData
+{
+	pg_atomic_uint32 nentries;	/* number of entries in the table */
+	/* generation counters, protected by the corresponding partition lock */
+	uint64		generation[NUM_RELSIZE_PARTITIONS];
+	LWLockPadded locks[NUM_RELSIZE_PARTITIONS];
+} RelSizeCtlData;
+
+static RelSizeCtlData *RelSizeCtl = NULL;
+static HTAB *RelSizeHash = NULL;
+
+#define RelSizePartition(hashcode) ((hashcode) % NUM_RELSIZE_PARTITIONS)
+#define RelSizePartitionLock(partition) (&RelSizeCtl->locks[partition].lock)
+
+static uint32 relsize_hash_tag(RelSizeTag *tag, RelFileNode rnode,
+							   ForkNumber forknum);
+static RelSizeEnt *relsize_enter(RelSizeTag *tag, uint32 hashcode,
+								 bool *found);
+static void relsize_forget_matching(Oid dbid);
+
+
+/*
+ * RelSizeShmemSize --- report amount of shared memory space needed
+ */
+Size
+RelSizeShmemSize(void)
+{
+	Size		size;
+
+	if (relsize_cache_entries == 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(RelSizeCtlData));
+	size = add_size(size, hash_estimate_size(relsize_cache_entries,
+											 sizeof(RelSizeEnt)));
+	return size;
+}
+
+/*
+ * RelSizeShmemInit --- initialize this module's shared memory
+ */
+void
+RelSizeShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (relsize_cache_entries == 0)
+		return;
+
+	RelSizeCtl = (RelSizeCtlData *)
+		ShmemInitStruct("Relation Size Cache Control",
+						sizeof(RelSizeCtlData), &found);
+	if (!found)
+	{
+		pg_atomic_init_u32(&RelSizeCtl->nentries, 0);
+		for (int i = 0; i < NUM_RELSIZE_PARTITIONS; i++)
+		{
+			RelSizeCtl->generation[i] = 0;
+			LWLockInitialize(&RelSizeCtl->locks[i].lock,
+							 LWTRANCHE_RELSIZE_CACHE);
+		}
+	}
+
+	info.keysize = sizeof(RelSizeTag);
+	info.entrysize = sizeof(RelSizeEnt);
+	info.num_partitions = NUM_RELSIZE_PARTITIONS;
+
+	RelSizeHash = ShmemInitHash("Relation Size Cache",
+								relsize_cache_entries,
+								relsize_cache_entries,
+								&info,
+								HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+}
+
+/*
+ * Fill in a hash key and compute its hash code.
+ */
+static uint32
+relsize_hash_tag(RelSizeTag *tag, RelFileNode rnode, ForkNumber forknum)
+{
+	/* clear any padding, since the key is hashed and compared as a blob */
+	MemSet(tag, 0, sizeof(RelSizeTag));
+	tag->rnode = rnode;
+	tag->forknum = forknum;
+
+	return get_hash_value(RelSizeHash, (void *) tag);
+}
+
+/*
+ * Find or create the entry for a tag.  Returns NULL if the table is full.
+ * The caller must hold the partition lock exclusively.
+ *
+ * The entry count is maintained without a lock covering all partitions, so
+ * concurrent insertions can overshoot relsize_cache_entries slightly.  That's
+ * harmless; HASH_ENTER_NULL copes if we really run out of space.
+ */
+static RelSizeEnt *
+relsize_enter(RelSizeTag *tag, uint32 hashcode, bool *found)
+{
+	RelSizeEnt *ent;
+
+	ent = (RelSizeEnt *) hash_search_with_hash_value(RelSizeHash,
+													 (void *) tag,
+													 hashcode,
+													 HASH_FIND,
+													 NULL);
+	if (ent != NULL)
+	{
+		*found = true;
+		return ent;
+	}
+
+	if (pg_atomic_read_u32(&RelSizeCtl->nentries) >= relsize_cache_entries)
+		return NULL;
+
+	ent = (RelSizeEnt *) hash_search_with_hash_value(RelSizeHash,
+													 (void *) tag,
+													 hashcode,
+													 HASH_ENTER_NULL,
+													 found);
+	if (ent != NULL)
+		pg_atomic_fetch_add_u32(&RelSizeCtl->nentries, 1);
+	return ent;
+}
+
+/*
+ * RelSizeCacheLookup
+ *		Return the cached size of a relation fork, or InvalidBlockNumber.
+ *
+ * On a miss, *generation is set to a value that must be passed to
+ * RelSizeCacheInsert() after the size has been obtained some other way.
+ */
+BlockNumber
+RelSizeCacheLookup(RelFileNode rnode, ForkNumber forknum, uint64 *generation)
+{
+	RelSizeTag	tag;
+	RelSizeEnt *ent;
+	uint32		hashcode;
+	int			partition;
+	BlockNumber result = InvalidBlockNumber;
+
+	*generation = 0;
+	if (RelSizeHash == NULL)
+		return InvalidBlockNumber;
+
+	hashcode = relsize_hash_tag(&tag, rnode, forknum);
+	partition = RelSizePartition(hashcode);
+
+	LWLockAcquire(RelSizePartitionLock(partition), LW_SHARED);
+	ent = (RelSizeEnt *) hash_search_with_hash_value(RelSizeHash,
+													 (void *) &tag,
+													 hashcode,
+													 HASH_FIND,
+													 NULL);
+	if (ent)
+		result = pg_atomic_read_u32(&ent->nblocks);
+	*generation = RelSizeCtl->generation[partition];
+	LWLockRelease(RelSizePartitionLock(partition));
+
+	return result;
+}
+
+/*
+ * RelSizeCacheInsert
+ *		Enter a fork size obtained from the storage manager.
+ *
+ * generation is the value reported by the RelSizeCacheLookup() call that
+ * preceded asking the storage manager.  If the size of any fork in the same
+ * partition has changed since then, nblocks might be stale, and we don't
+ * enter it.
+ */
+void
+RelSizeCacheInsert(RelFileNode rnode, ForkNumber forknum, BlockNumber nblocks,
+				   uint64 generation)
+{
+	RelSizeTag	tag;
+	RelSizeEnt *ent;
+	uint32		hashcode;
+	int			partition;
+	bool		found;
+
+	if (RelSizeHash == NULL)
+		return;
+
+	hashcode = relsize_hash_tag(&tag, rnode, forknum);
+	partition = RelSizePartition(hashcode);
+
+	LWLockAcquire(RelSizePartitionLock(partition), LW_EXCLUSIVE);
+	if (RelSizeCtl->generation[partition] == generation)
+	{
+		ent = relsize_enter(&tag, hashcode, &found);
+		if (ent != NULL && !found)
+			pg_atomic_init_u32(&ent->nblocks, nblocks);
+	}
+	LWLockRelease(RelSizePartitionLock(partition));
+}
+
+/*
+ * RelSizeCacheExtend
+ *		Record that a fork has been extended to at least nblocks blocks.
+ *
+ * The caller must have extended the fork before calling this.
+ */
+void
+RelSizeCacheExtend(RelFileNode rnode, ForkNumber forknum, BlockNumber nblocks)
+{
+	RelSizeTag	tag;
+	RelSizeEnt *ent;
+	uint32		hashcode;
+	int			partition;
+	bool		found;
+
+	if (RelSizeHash == NULL)
+		return;
+
+	hashcode = relsize_hash_tag(&tag, rnode, forknum);
+	partition = RelSizePartition(hashcode);
+
+	/*
+	 * Usually the fork is already cached, and we only have to advance its
+	 * size.  Concurrent extensions can finish in any order, so never move it
+	 * backwards.  Truncation takes the lock exclusively, so it can't
+	 * interfere.
+	 */
+	LWLockAcquire(RelSizePartitionLock(partition), LW_SHARED);
+	ent = (RelSizeEnt *) hash_search_with_hash_value(RelSizeHash,
+													 (void *) &tag,
+													 hashcode,
+													 HASH_FIND,
+													 NULL);
+	if (ent != NULL)
+	{
+		uint32		oldval = pg_atomic_read_u32(&ent->nblocks);
+
+		/* a failed compare-exchange updates oldval, so just retry */
+		while (oldval < nblocks)
+		{
+			if (pg_atomic_compare_exchange_u32(&ent->nblocks, &oldval,
+											   nblocks))
+				break;
+		}
+	}
+	LWLockRelease(RelSizePartitionLock(partition));
+
+	if (ent != NULL)
+		return;
+
+	/*
+	 * Otherwise create the entry.  Its existence keeps a RelSizeCacheInsert()
+	 * of a size read before our extension from taking effect.  If the table
+	 * is full, advance the generation counter instead, since an entry might
+	 * be freed before that RelSizeCacheInsert() comes along.
+	 */
+	LWLockAcquire(RelSizePartitionLock(partition), LW_EXCLUSIVE);
+	ent = relsize_enter(&tag, hashcode, &found);
+	if (ent == NULL)
+		RelSizeCtl->generation[partition]++;
+	else if (!found)
+		pg_atomic_init_u32(&ent->nblocks, nblocks);
+	else if (pg_atomic_read_u32(&ent->nblocks) < nblocks)
+		pg_atomic_write_u32(&ent->nblocks, nblocks);
+	LWLockRelease(RelSizePartitionLock(partition));
+}
+
+/*
+ * RelSizeCacheSet
+ *		Record that a fork has been truncated to nblocks blocks.
+ */
+void
+RelSizeCacheSet(RelFileNode rnode, ForkNumber forknum, BlockNumber nblocks)
+{
+	RelSizeTag	tag;
+	RelSizeEnt *ent;
+	uint32		hashcode;
+	int			partition;
+	bool		found;
+
+	if (RelSizeHash == NULL)
+		return;
+
+	hashcode = relsize_hash_tag(&tag, rnode, forknum);
+	partition = RelSizePartition(hashcode);
+
+	/*
+	 * Advance the generation counter even if no entry can be made, so that
+	 * concurrent RelSizeCacheInsert calls don't enter a size from before the
+	 * truncation.
+	 */
+	LWLockAcquire(RelSizePartitionLock(partition), LW_EXCLUSIVE);
+	RelSizeCtl->generation[partition]++;
+
+	ent = relsize_enter(&tag, hashcode, &found);
+	if (ent != NULL)
+	{
+		if (found)
+			pg_atomic_write_u32(&ent->nblocks, nblocks);
+		else
+			pg_atomic_init_u32(&ent->nblocks, nblocks);
+	}
+	LWLockRelease(RelSizePartitionLock(partition));
+}
+
+/*
+ * RelSizeCacheForget
+ *		Discard the cached size of a fork, if any.
+ */
+void
+RelSizeCacheForget(RelFileNode rnode, ForkNumber forknum)
+{
+	RelSizeTag	tag;
+	uint32		hashcode;
+	int			partition;
+
+	if (RelSizeHash == NULL)
+		return;
+
+	hashcode = relsize_hash_tag(&tag, rnode, forknum);
+	partition = RelSizePartition(hashcode);
+
+	LWLockAcquire(RelSizePartitionLock(partition), LW_EXCLUSIVE);
+	RelSizeCtl->generation[partition]++;
+	if (hash_search_with_hash_value(RelSizeHash,
+									(void *) &tag,
+									hashcode,
+									HASH_REMOVE,
+									NULL) != NULL)
+		pg_atomic_fetch_sub_u32(&RelSizeCtl->nentries, 1);
+	LWLockRelease(RelSizePartitionLock(partition));
+}
+
+/*
+ * Discard all entries for database dbid, or all entries if dbid is
+ * InvalidOid.
+ */
+static void
+relsize_forget_matching(Oid dbid)
+{
+	HASH_SEQ_STATUS status;
+	RelSizeEnt *ent;
+
+	if (RelSizeHash == NULL)
+		return;
+
+	for (int i = 0; i < NUM_RELSIZE_PARTITIONS; i++)
+	{
+		LWLockAcquire(RelSizePartitionLock(i), LW_EXCLUSIVE);
+		RelSizeCtl->generation[i]++;
+	}
+
+	hash_seq_init(&status, RelSizeHash);
+	while ((ent = (RelSizeEnt *) hash_seq_search(&status)) != NULL)
+	{
+		if (OidIsValid(dbid) && ent->tag.rnode.dbNode != dbid)
+			continue;
+		if (hash_search(RelSizeHash, (void *) &ent->tag,
+						HASH_REMOVE, NULL) == NULL)
+			elog(ERROR, "relation size cache corrupted");
+		pg_atomic_fetch_sub_u32(&RelSizeCtl->nentries, 1);
+	}
+
+	for (int i = NUM_RELSIZE_PARTITIONS; --i >= 0;)
+		LWLockRelease(RelSizePartitionLock(i));
+}
+
+/*
+ * RelSizeCacheForgetDatabase
+ *		Discard the cached sizes of all forks in a database.
+ *
+ * This must be called whenever the files of a database are removed or moved
+ * wholesale.
+ */
+void
+RelSizeCacheForgetDatabase(Oid dbid)
+{
+	Assert(OidIsValid(dbid));
+	relsize_forget_matching(dbid);
+}
+
+/*
+ * RelSizeCacheForgetAll
+ *		Discard all cached sizes.
+ */
+void
+RelSizeCacheForgetAll(void)
+{
+	relsize_forget_matching(InvalidOid);
+}
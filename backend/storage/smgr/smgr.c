@@ -22,6 +22,7 @@
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
 #include "storage/md.h"
+#include "storage/relsize.h"
 #include "storage/smgr.h"
 #include "utils/hsearch.h"
 #include "utils/inval.h"
@@ -50,6 +51,8 @@ typedef struct f_smgr
 								bool isRedo);
 	void		(*smgr_extend) (SMgrRelation reln, ForkNumber forknum,
 								BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_zeroextend) (SMgrRelation reln, ForkNumber forknum,
+									BlockNumber blocknum, int nblocks, bool skipFsync);
 	bool		(*smgr_prefetch) (SMgrRelation reln, ForkNumber forknum,
 								  BlockNumber blocknum);
 	void		(*smgr_read) (SMgrRelation reln, ForkNumber forknum,
@@ -75,6 +78,7 @@ static const f_smgr smgrsw[] = {
 		.smgr_exists = mdexists,
 		.smgr_unlink = mdunlink,
 		.smgr_extend = mdextend,
+		.smgr_zeroextend = mdzeroextend,
 		.smgr_prefetch = mdprefetch,
 		.smgr_read = mdread,
 		.smgr_write = mdwrite,
@@ -333,6 +337,13 @@ void
 smgrcreate(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 {
 	smgrsw[reln->smgr_which].smgr_create(reln, forknum, isRedo);
+
+	/*
+	 * There shouldn't be a cached size for a fork that didn't exist, but
+	 * during redo the fork might already be there, so play it safe.
+	 */
+	if (!RelFileNodeBackendIsTemp(reln->smgr_rnode))
+		RelSizeCacheForget(reln->smgr_rnode.node, forknum);
 }
 
 /*
@@ -442,7 +453,11 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 		int			which = rels[i]->smgr_which;
 
 		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		{
 			smgrsw[which].smgr_unlink(rnodes[i], forknum, isRedo);
+			if (!RelFileNodeBackendIsTemp(rnodes[i]))
+				RelSizeCacheForget(rnodes[i].node, forknum);
+		}
 	}
 
 	pfree(rnodes);
@@ -474,6 +489,38 @@ smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 		reln->smgr_cached_nblocks[forknum] = blocknum + 1;
 	else
 		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+
+	if (!RelFileNodeBackendIsTemp(reln->smgr_rnode))
+		RelSizeCacheExtend(reln->smgr_rnode.node, forknum, blocknum + 1);
+}
+
+/*
+ *	smgrzeroextend() -- Add new zeroed out blocks to a file.
+ *
+ *		Similar to smgrextend(), except the relation can be extended by
+ *		multiple blocks at once and the added blocks will be filled with
+ *		zeroes.
+ */
+void
+smgrzeroextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			   int nblocks, bool skipFsync)
+{
+	smgrsw[reln->smgr_which].smgr_zeroextend(reln, forknum, blocknum,
+											 nblocks, skipFsync);
+
+	/*
+	 * Normally we expect this to increase the fork size by nblocks, but if
+	 * the cached value isn't as expected, just invalidate it so the next call
+	 * asks the kernel.
+	 */
+	if (reln->smgr_cached_nblocks[forknum] == blocknum)
+		reln->smgr_cached_nblocks[forknum] = blocknum + nblocks;
+	else
+		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+
+	if (!RelFileNodeBackendIsTemp(reln->smgr_rnode))
+		RelSizeCacheExtend(reln->smgr_rnode.node, forknum,
+						   blocknum + nblocks);
 }
 
 /*
@@ -548,15 +595,31 @@ BlockNumber
 smgrnblocks(SMgrRelation reln, ForkNumber forknum)
 {
 	BlockNumber result;
+	uint64		generation;
+	bool		shared = !RelFileNodeBackendIsTemp(reln->smgr_rnode);
 
 	/* Check and return if we get the cached value for the number of blocks. */
 	result = smgrnblocks_cached(reln, forknum);
 	if (result != InvalidBlockNumber)
 		return result;
 
+	/* Next, try the shared relation size cache. */
+	if (shared)
+	{
+		result = RelSizeCacheLookup(reln->smgr_rnode.node, forknum,
+									&generation);
+		if (result != InvalidBlockNumber)
+		{
+			reln->smgr_cached_nblocks[forknum] = result;
+			return result;
+		}
+	}
+
 	result = smgrsw[reln->smgr_which].smgr_nblocks(reln, forknum);
 
 	reln->smgr_cached_nblocks[forknum] = result;
+	if (shared)
+		RelSizeCacheInsert(reln->smgr_rnode.node, forknum, result, generation);
 
 	return result;
 }
@@ -619,9 +682,14 @@ smgrtruncate(SMgrRelation reln, ForkNumber *forknum, int nforks, BlockNumber *nb
 	{
 		/* Make the cached size is invalid if we encounter an error. */
 		reln->smgr_cached_nblocks[forknum[i]] = InvalidBlockNumber;
+		if (!RelFileNodeBackendIsTemp(reln->smgr_rnode))
+			RelSizeCacheForget(reln->smgr_rnode.node, forknum[i]);
 
 		smgrsw[reln->smgr_which].smgr_truncate(reln, forknum[i], nblocks[i]);
 
+		if (!RelFileNodeBackendIsTemp(reln->smgr_rnode))
+			RelSizeCacheSet(reln->smgr_rnode.node, forknum[i], nblocks[i]);
+
 		/*
 		 * We might as well update the local smgr_cached_nblocks values. The
 		 * smgr cache inval message that this function sent will cause other
@@ -90,6 +90,7 @@ static CycleCtr checkpoint_cycle_ctr = 0;
 typedef struct SyncOps
 {
 	int			(*sync_syncfiletag) (const FileTag *ftag, char *path);
+	int			(*sync_writebackfiletag) (const FileTag *ftag, char *path);
 	int			(*sync_unlinkfiletag) (const FileTag *ftag, char *path);
 	bool		(*sync_filetagmatches) (const FileTag *ftag,
 										const FileTag *candidate);
@@ -102,6 +103,7 @@ static const SyncOps syncsw[] = {
 	/* magnetic disk */
 	[SYNC_HANDLER_MD] = {
 		.sync_syncfiletag = mdsyncfiletag,
+		.sync_writebackfiletag = mdwritebackfiletag,
 		.sync_unlinkfiletag = mdunlinkfiletag,
 		.sync_filetagmatches = mdfiletagmatches
 	},
@@ -123,6 +125,8 @@ static const SyncOps syncsw[] = {
 	}
 };
 
+static int	pending_fsync_cmp(const void *a, const void *b);
+
 /*
  * Initialize data structures for the file sync tracking.
  */
@@ -297,6 +301,8 @@ ProcessSyncRequests(void)
 
 	HASH_SEQ_STATUS hstat;
 	PendingFsyncEntry *entry;
+	PendingFsyncEntry **entries;
+	int			nentries;
 	int			absorb_counter;
 
 	/* Statistics on sync times */
@@ -366,17 +372,68 @@ ProcessSyncRequests(void)
 	/* Set flag to detect failure if we don't reach the end of the loop */
 	sync_in_progress = true;
 
-	/* Now scan the hashtable for fsync requests to process */
-	absorb_counter = FSYNCS_PER_ABSORB;
+	/*
+	 * Collect the requests to process, and sort them by file.  That way we
+	 * visit the segments of each relation together and in order, which is
+	 * kinder to the filesystem than the hash table's random order.  It also
+	 * means that we don't need to worry about visiting entries that get added
+	 * by AbsorbSyncRequests() in the loops below.  Absorbing never removes
+	 * entries, so the pointers remain valid until we remove them ourselves.
+	 */
+	entries = (PendingFsyncEntry **)
+		palloc(sizeof(PendingFsyncEntry *) * hash_get_num_entries(pendingOps));
+	nentries = 0;
 	hash_seq_init(&hstat, pendingOps);
 	while ((entry = (PendingFsyncEntry *) hash_seq_search(&hstat)) != NULL)
+		entries[nentries++] = entry;
+	qsort(entries, nentries, sizeof(PendingFsyncEntry *), pending_fsync_cmp);
+
+	absorb_counter = FSYNCS_PER_ABSORB;
+
+	/*
+	 * Before fsyncing anything, ask the kernel to start writeback of all the
+	 * files we're about to sync.  Otherwise each fsync would have to write
+	 * out its file's dirty data from scratch, one file at a time, while this
+	 * way the kernel can write them all out concurrently and most of the
+	 * fsyncs below will only have to wait for I/O that's already under way.
+	 * This is governed by checkpoint_flush_after, like the flushing done
+	 * during the write phase of the checkpoint; it's pointless on platforms
+	 * where we can't initiate writeback, and that's where it defaults to 0.
+	 * Errors are ignored here; they'll be dealt with by the fsync pass.
+	 */
+	if (enableFsync && checkpoint_flush_after > 0)
+	{
+		for (int i = 0; i < nentries; i++)
+		{
+			char		path[MAXPGPATH];
+
+			entry = entries[i];
+			if (entry->canceled || entry->cycle_ctr == sync_cycle_ctr ||
+				syncsw[entry->tag.handler].sync_writebackfiletag == NULL)
+				continue;
+
+			if (--absorb_counter <= 0)
+			{
+				AbsorbSyncRequests();
+				absorb_counter = FSYNCS_PER_ABSORB;
+			}
+
+			(void) syncsw[entry->tag.handler].sync_writebackfiletag(&entry->tag,
+																	path);
+		}
+	}
+
+	/* Now process the fsync requests */
+	for (int i = 0; i < nentries; i++)
 	{
 		int			failures;
 
+		entry = entries[i];
+
 		/*
-		 * If the entry is new then don't process it this time; it is new.
-		 * Note "continue" bypasses the hash-remove call at the bottom of the
-		 * loop.
+		 * If the entry was canceled and then requested again since we
+		 * collected it, then don't process it this time; it is new.  Note
+		 * "continue" bypasses the hash-remove call at the bottom of the loop.
 		 */
 		if (entry->cycle_ctr == sync_cycle_ctr)
 			continue;
@@ -393,10 +450,7 @@ ProcessSyncRequests(void)
 		{
 			/*
 			 * If in checkpointer, we want to absorb pending requests every so
-			 * often to prevent overflow of the fsync request queue.  It is
-			 * unspecified whether newly-added entries will be visited by
-			 * hash_seq_search, but we don't care since we don't need to
-			 * process them anyway.
+			 * often to prevent overflow of the fsync request queue.
 			 */
 			if (--absorb_counter <= 0)
 			{
@@ -471,7 +525,9 @@ ProcessSyncRequests(void)
 		/* We are done with this entry, remove it */
 		if (hash_search(pendingOps, &entry->tag, HASH_REMOVE, NULL) == NULL)
 			elog(ERROR, "pendingOps corrupted");
-	}							/* end loop over hashtable entries */
+	}							/* end loop over entries */
+
+	pfree(entries);
 
 	/* Return sync performance metrics for report at checkpoint end */
 	CheckpointStats.ckpt_sync_rels = processed;
@@ -482,6 +538,30 @@ ProcessSyncRequests(void)
 	sync_in_progress = false;
 }
 
+/*
+ * qsort comparator for PendingFsyncEntry pointers, ordering them by file.
+ */
+static int
+pending_fsync_cmp(const void *a, const void *b)
+{
+	const FileTag *ta = &(*(PendingFsyncEntry *const *) a)->tag;
+	const FileTag *tb = &(*(PendingFsyncEntry *const *) b)->tag;
+
+	if (ta->handler != tb->handler)
+		return ta->handler < tb->handler ? -1 : 1;
+	if (ta->rnode.spcNode != tb->rnode.spcNode)
+		return ta->rnode.spcNode < tb->rnode.spcNode ? -1 : 1;
+	if (ta->rnode.dbNode != tb->rnode.dbNode)
+		return ta->rnode.dbNode < tb->rnode.dbNode ? -1 : 1;
+	if (ta->rnode.relNode != tb->rnode.relNode)
+		return ta->rnode.relNode < tb->rnode.relNode ? -1 : 1;
+	if (ta->forknum != tb->forknum)
+		return ta->forknum < tb->forknum ? -1 : 1;
+	if (ta->segno != tb->segno)
+		return ta->segno < tb->segno ? -1 : 1;
+	return 0;
+}
+
 /*
  * RememberSyncRequest() -- callback from checkpointer side of sync request
  *
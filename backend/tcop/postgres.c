@@ -4060,6 +4060,7 @@ PostgresMain(int argc, char *argv[],
 
 		/* Initialize MaxBackends (if under postmaster, was done already) */
 		InitializeMaxBackends();
+		InitializeFastPathLocks();
 	}
 
 	/* Early initialization */
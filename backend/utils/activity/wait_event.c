@@ -212,6 +212,9 @@ pgstat_get_wait_activity(WaitEventActivity w)
 		case WAIT_EVENT_ARCHIVER_MAIN:
 			event_name = "ArchiverMain";
 			break;
+		case WAIT_EVENT_AUTOPREWARM_MAIN:
+			event_name = "AutoPrewarmMain";
+			break;
 		case WAIT_EVENT_AUTOVACUUM_MAIN:
 			event_name = "AutoVacuumMain";
 			break;
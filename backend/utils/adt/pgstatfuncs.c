@@ -1943,6 +1943,83 @@ pg_stat_get_slru(PG_FUNCTION_ARGS)
 	return (Datum) 0;
 }
 
+/*
+ * Returns statistics of LWLock contention, one row per tranche.
+ */
+Datum
+pg_stat_get_lwlock(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_LWLOCK_COLS	6
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	int			i;
+	PgStat_LWLockStats *stats;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* request LWLock stats from the stat collector */
+	stats = pgstat_fetch_lwlock();
+
+	for (i = 0; i < NUM_LWLOCK_STATS_TRANCHES; i++)
+	{
+		/* for each row */
+		Datum		values[PG_STAT_GET_LWLOCK_COLS];
+		bool		nulls[PG_STAT_GET_LWLOCK_COLS];
+		PgStat_LWLockStats stat;
+		const char *name;
+
+		name = GetLWLockStatsTrancheName(i);
+
+		/* skip the gaps left by removed individual LWLocks */
+		if (strncmp(name, "<unassigned:", 12) == 0)
+			continue;
+
+		stat = stats[i];
+		MemSet(values, 0, sizeof(values));
+		MemSet(nulls, 0, sizeof(nulls));
+
+		values[0] = PointerGetDatum(cstring_to_text(name));
+		values[1] = Int64GetDatum(stat.acquisitions);
+		values[2] = Int64GetDatum(stat.waits);
+		values[3] = Int64GetDatum(stat.spins);
+		/* convert from microseconds to milliseconds */
+		values[4] = Float8GetDatum(((double) stat.wait_time) / 1000.0);
+		values[5] = TimestampTzGetDatum(stat.stat_reset_timestamp);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
 Datum
 pg_stat_get_xact_numscans(PG_FUNCTION_ARGS)
 {
@@ -525,6 +525,30 @@ InitializeMaxBackends(void)
 		elog(ERROR, "too many backends configured");
 }
 
+/*
+ * Initialize the number of fast-path lock slots in PGPROC.
+ *
+ * The slots are sized from max_locks_per_transaction, on the theory that a
+ * backend that is expected to hold that many locks at a time should be able
+ * to hold most of them without touching the shared lock table.  We use the
+ * next power of two groups of FP_LOCK_SLOTS_PER_GROUP slots, capped at
+ * FP_LOCK_GROUPS_PER_BACKEND_MAX.
+ *
+ * Like InitializeMaxBackends(), this must be called before shared memory
+ * size is determined, and in EXEC_BACKEND environment the value is passed
+ * down from postmaster to subprocesses via BackendParameters.
+ */
+void
+InitializeFastPathLocks(void)
+{
+	Assert(FastPathLockGroupsPerBackend == 0);
+
+	FastPathLockGroupsPerBackend = 1;
+	while (FastPathLockGroupsPerBackend < FP_LOCK_GROUPS_PER_BACKEND_MAX &&
+		   FastPathLockGroupsPerBackend * FP_LOCK_SLOTS_PER_GROUP < max_locks_per_xact)
+		FastPathLockGroupsPerBackend *= 2;
+}
+
 /*
  * Early initialization of a backend (either standalone or under postmaster).
  * This happens even before InitPostgres.
@@ -32,15 +32,20 @@
 #endif
 #include <unistd.h>
 
+#include "access/clog.h"
 #include "access/commit_ts.h"
 #include "access/gin.h"
+#include "access/multixact.h"
 #include "access/rmgr.h"
+#include "access/slru.h"
+#include "access/subtrans.h"
 #include "access/tableam.h"
 #include "access/toast_compression.h"
 #include "access/transam.h"
 #include "access/twophase.h"
 #include "access/xact.h"
 #include "access/xlog_internal.h"
+#include "access/xlogprefetch.h"
 #include "catalog/namespace.h"
 #include "catalog/pg_authid.h"
 #include "catalog/storage.h"
@@ -67,6 +72,7 @@
 #include "parser/parser.h"
 #include "parser/scansup.h"
 #include "pgstat.h"
+#include "postmaster/autoprewarm.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
@@ -85,6 +91,7 @@
 #include "storage/large_object.h"
 #include "storage/pg_shmem.h"
 #include "storage/predicate.h"
+#include "storage/relsize.h"
 #include "storage/proc.h"
 #include "storage/standby.h"
 #include "tcop/tcopprot.h"
@@ -184,6 +191,7 @@ static void assign_syslog_facility(int newval, void *extra);
 static void assign_syslog_ident(const char *newval, void *extra);
 static void assign_session_replication_role(int newval, void *extra);
 static bool check_temp_buffers(int *newval, void **extra, GucSource source);
+static bool check_slru_buffers(int *newval, void **extra, GucSource source);
 static bool check_bonjour(bool *newval, void **extra, GucSource source);
 static bool check_ssl(bool *newval, void **extra, GucSource source);
 static bool check_stage_log_stats(bool *newval, void **extra, GucSource source);
@@ -208,6 +216,7 @@ static bool check_max_wal_senders(int *newval, void **extra, GucSource source);
 static bool check_autovacuum_work_mem(int *newval, void **extra, GucSource source);
 static bool check_effective_io_concurrency(int *newval, void **extra, GucSource source);
 static bool check_maintenance_io_concurrency(int *newval, void **extra, GucSource source);
+static bool check_recovery_prefetch(bool *newval, void **extra, GucSource source);
 static bool check_huge_page_size(int *newval, void **extra, GucSource source);
 static bool check_client_connection_check_interval(int *newval, void **extra, GucSource source);
 static void assign_pgstat_temp_directory(const char *newval, void *extra);
@@ -533,6 +542,31 @@ static struct config_enum_entry shared_memory_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry wal_compression_options[] = {
+	{"pglz", WAL_COMPRESSION_PGLZ, false},
+#ifdef USE_LZ4
+	{"lz4", WAL_COMPRESSION_LZ4, false},
+#endif
+	{"on", WAL_COMPRESSION_PGLZ, false},
+	{"off", WAL_COMPRESSION_NONE, false},
+	{"true", WAL_COMPRESSION_PGLZ, true},
+	{"false", WAL_COMPRESSION_NONE, true},
+	{"yes", WAL_COMPRESSION_PGLZ, true},
+	{"no", WAL_COMPRESSION_NONE, true},
+	{"1", WAL_COMPRESSION_PGLZ, true},
+	{"0", WAL_COMPRESSION_NONE, true},
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry logical_decoding_spill_compression_options[] = {
+	{"off", SPILL_COMPRESSION_NONE, false},
+	{"pglz", SPILL_COMPRESSION_PGLZ, false},
+#ifdef USE_LZ4
+	{"lz4", SPILL_COMPRESSION_LZ4, false},
+#endif
+	{NULL, 0, false}
+};
+
 static struct config_enum_entry default_toast_compression_options[] = {
 	{"pglz", TOAST_PGLZ_COMPRESSION, false},
 #ifdef  USE_LZ4
@@ -624,6 +658,7 @@ int			ssl_renegotiation_limit;
  */
 int			huge_pages;
 int			huge_page_size;
+bool		shared_memory_numa_interleave = false;
 
 /*
  * These variables are all dummies that don't do anything, except in some
@@ -743,6 +778,8 @@ const char *const config_group_names[] =
 	gettext_noop("Write-Ahead Log / Checkpoints"),
 	/* WAL_ARCHIVING */
 	gettext_noop("Write-Ahead Log / Archiving"),
+	/* WAL_RECOVERY */
+	gettext_noop("Write-Ahead Log / Recovery"),
 	/* WAL_ARCHIVE_RECOVERY */
 	gettext_noop("Write-Ahead Log / Archive Recovery"),
 	/* WAL_RECOVERY_TARGET */
@@ -1355,16 +1392,6 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
-	{
-		{"wal_compression", PGC_SUSET, WAL_SETTINGS,
-			gettext_noop("Compresses full-page writes written in WAL file."),
-			NULL
-		},
-		&wal_compression,
-		false,
-		NULL, NULL, NULL
-	},
-
 	{
 		{"wal_init_zero", PGC_SUSET, WAL_SETTINGS,
 			gettext_noop("Writes zeroes to new WAL files before first use."),
@@ -1385,6 +1412,17 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"recovery_prefetch", PGC_SIGHUP, WAL_RECOVERY,
+			gettext_noop("Prefetches referenced blocks during recovery."),
+			gettext_noop("Looks ahead in the WAL to find blocks that will be needed by replay, "
+						 "and starts reading them in advance.")
+		},
+		&recovery_prefetch,
+		false,
+		check_recovery_prefetch, NULL, NULL
+	},
+
 	{
 		{"log_checkpoints", PGC_SIGHUP, LOGGING_WHAT,
 			gettext_noop("Logs each checkpoint."),
@@ -2161,6 +2199,27 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"autoprewarm", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Periodically saves the list of blocks in shared buffers, and reloads them at startup."),
+			NULL
+		},
+		&autoprewarm,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"shared_memory_numa_interleave", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Interleaves shared memory across NUMA nodes."),
+			gettext_noop("Applies to the main shared memory segment and to dynamic shared memory segments. "
+						 "Only supported on Linux.")
+		},
+		&shared_memory_numa_interleave,
+		false,
+		NULL, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, false, NULL, NULL, NULL
@@ -2393,6 +2452,115 @@ static struct config_int ConfigureNamesInt[] =
 		check_temp_buffers, NULL, NULL
 	},
 
+	{
+		{"transaction_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the transaction status cache."),
+			gettext_noop("0 means to size it from shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&transaction_buffers,
+		0, 0, SLRU_MAX_ALLOWED_BUFFERS,
+		check_slru_buffers, NULL, NULL
+	},
+
+	{
+		{"subtransaction_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the subtransaction cache."),
+			gettext_noop("0 means to size it from shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&subtransaction_buffers,
+		0, 0, SLRU_MAX_ALLOWED_BUFFERS,
+		check_slru_buffers, NULL, NULL
+	},
+
+	{
+		{"commit_timestamp_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the commit timestamp cache."),
+			gettext_noop("0 means to size it from shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&commit_timestamp_buffers,
+		0, 0, SLRU_MAX_ALLOWED_BUFFERS,
+		check_slru_buffers, NULL, NULL
+	},
+
+	{
+		{"multixact_offset_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the MultiXact offset cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&multixact_offset_buffers,
+		8, 4, SLRU_MAX_ALLOWED_BUFFERS,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"multixact_member_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the MultiXact member cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&multixact_member_buffers,
+		16, 4, SLRU_MAX_ALLOWED_BUFFERS,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"notify_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the LISTEN/NOTIFY message cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&notify_buffers,
+		8, 4, SLRU_MAX_ALLOWED_BUFFERS,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"serializable_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the serializable transaction cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&serializable_buffers,
+		16, 4, SLRU_MAX_ALLOWED_BUFFERS,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"autoprewarm_interval", PGC_SIGHUP, RESOURCES_MEM,
+			gettext_noop("Sets the time between saves of the list of blocks in shared buffers."),
+			gettext_noop("If set to zero, the list is only saved at shutdown."),
+			GUC_UNIT_S
+		},
+		&autoprewarm_interval,
+		300, 0, INT_MAX / 1000,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"recovery_prefetch_distance", PGC_SIGHUP, WAL_RECOVERY,
+			gettext_noop("Sets how far ahead of replay to look for blocks to prefetch."),
+			gettext_noop("This is an amount of WAL."),
+			GUC_UNIT_BYTE
+		},
+		&recovery_prefetch_distance,
+		512 * 1024, 64 * 1024, 1024 * 1024 * 1024,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"relsize_cache_entries", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of relation fork sizes cached in shared memory."),
+			gettext_noop("0 disables the cache.")
+		},
+		&relsize_cache_entries,
+		16384, 0, INT_MAX / 2,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"port", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
 			gettext_noop("Sets the TCP port the server listens on."),
@@ -2872,6 +3040,17 @@ static struct config_int ConfigureNamesInt[] =
 		check_wal_buffers, NULL, NULL
 	},
 
+	{
+		{"wal_insert_locks", PGC_POSTMASTER, WAL_SETTINGS,
+			gettext_noop("Sets the number of locks used for concurrent insertions into WAL."),
+			gettext_noop("A higher value allows more backends to copy records into the "
+						 "WAL buffers concurrently, at some extra cost when flushing.")
+		},
+		&wal_insert_locks,
+		8, 1, 128,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_writer_delay", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Time between WAL flushes performed in the WAL writer."),
@@ -4907,6 +5086,26 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, assign_xlog_sync_method, NULL
 	},
 
+	{
+		{"logical_decoding_spill_compression", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Compresses changes spilled to disk by logical decoding with specified method."),
+			NULL
+		},
+		&logical_decoding_spill_compression,
+		SPILL_COMPRESSION_NONE, logical_decoding_spill_compression_options,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"wal_compression", PGC_SUSET, WAL_SETTINGS,
+			gettext_noop("Compresses full-page writes written in WAL file with specified method."),
+			NULL
+		},
+		&wal_compression,
+		WAL_COMPRESSION_NONE, wal_compression_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"xmlbinary", PGC_USERSET, CLIENT_CONN_STATEMENT,
 			gettext_noop("Sets how binary values are to be encoded in XML."),
@@ -11815,6 +12014,18 @@ check_temp_buffers(int *newval, void **extra, GucSource source)
 	return true;
 }
 
+static bool
+check_slru_buffers(int *newval, void **extra, GucSource source)
+{
+	/* 0 means automatic sizing; otherwise use the same minimum as the rest */
+	if (*newval != 0 && *newval < 4)
+	{
+		GUC_check_errdetail("The value must be 0 or at least 4.");
+		return false;
+	}
+	return true;
+}
+
 static bool
 check_bonjour(bool *newval, void **extra, GucSource source)
 {
@@ -12108,6 +12319,19 @@ check_maintenance_io_concurrency(int *newval, void **extra, GucSource source)
 	return true;
 }
 
+static bool
+check_recovery_prefetch(bool *newval, void **extra, GucSource source)
+{
+#ifndef USE_PREFETCH
+	if (*newval)
+	{
+		GUC_check_errdetail("recovery_prefetch must be disabled on platforms that lack posix_fadvise().");
+		return false;
+	}
+#endif							/* USE_PREFETCH */
+	return true;
+}
+
 static bool
 check_huge_page_size(int *newval, void **extra, GucSource source)
 {
@@ -187,6 +187,7 @@ typedef struct SerializedSnapshotData
 	uint32		xcnt;
 	int32		subxcnt;
 	bool		suboverflowed;
+	TransactionId subxoverflow_xmin;
 	bool		takenDuringRecovery;
 	CommandId	curcid;
 	TimestampTz whenTaken;
@@ -545,6 +546,7 @@ SetTransactionSnapshot(Snapshot sourcesnap, VirtualTransactionId *sourcevxid,
 		memcpy(CurrentSnapshot->subxip, sourcesnap->subxip,
 			   sourcesnap->subxcnt * sizeof(TransactionId));
 	CurrentSnapshot->suboverflowed = sourcesnap->suboverflowed;
+	CurrentSnapshot->subxoverflow_xmin = sourcesnap->subxoverflow_xmin;
 	CurrentSnapshot->takenDuringRecovery = sourcesnap->takenDuringRecovery;
 	/* NB: curcid should NOT be copied, it's a local matter */
 
@@ -638,13 +640,10 @@ CopySnapshot(Snapshot snapshot)
 		newsnap->xip = NULL;
 
 	/*
-	 * Setup subXID array. Don't bother to copy it if it had overflowed,
-	 * though, because it's not used anywhere in that case. Except if it's a
-	 * snapshot taken during recovery; all the top-level XIDs are in subxip as
-	 * well in that case, so we mustn't lose them.
+	 * Setup subXID array.  We need it even if it had overflowed, see
+	 * XidInMVCCSnapshot().
 	 */
-	if (snapshot->subxcnt > 0 &&
-		(!snapshot->suboverflowed || snapshot->takenDuringRecovery))
+	if (snapshot->subxcnt > 0)
 	{
 		newsnap->subxip = (TransactionId *) ((char *) newsnap + subxipoff);
 		memcpy(newsnap->subxip, snapshot->subxip,
@@ -1509,6 +1508,7 @@ ImportSnapshot(const char *idstr)
 		snapshot.subxcnt = 0;
 		snapshot.subxip = NULL;
 	}
+	snapshot.subxoverflow_xmin = snapshot.xmin;
 
 	snapshot.takenDuringRecovery = parseIntFromText("rec:", &filebuf, path);
 
@@ -2102,8 +2102,7 @@ EstimateSnapshotSpace(Snapshot snap)
 	/* We allocate any XID arrays needed in the same palloc block. */
 	size = add_size(sizeof(SerializedSnapshotData),
 					mul_size(snap->xcnt, sizeof(TransactionId)));
-	if (snap->subxcnt > 0 &&
-		(!snap->suboverflowed || snap->takenDuringRecovery))
+	if (snap->subxcnt > 0)
 		size = add_size(size,
 						mul_size(snap->subxcnt, sizeof(TransactionId)));
 
@@ -2128,19 +2127,12 @@ SerializeSnapshot(Snapshot snapshot, char *start_address)
 	serialized_snapshot.xcnt = snapshot->xcnt;
 	serialized_snapshot.subxcnt = snapshot->subxcnt;
 	serialized_snapshot.suboverflowed = snapshot->suboverflowed;
+	serialized_snapshot.subxoverflow_xmin = snapshot->subxoverflow_xmin;
 	serialized_snapshot.takenDuringRecovery = snapshot->takenDuringRecovery;
 	serialized_snapshot.curcid = snapshot->curcid;
 	serialized_snapshot.whenTaken = snapshot->whenTaken;
 	serialized_snapshot.lsn = snapshot->lsn;
 
-	/*
-	 * Ignore the SubXID array if it has overflowed, unless the snapshot was
-	 * taken during recovery - in that case, top-level XIDs are in subxip as
-	 * well, and we mustn't lose them.
-	 */
-	if (serialized_snapshot.suboverflowed && !snapshot->takenDuringRecovery)
-		serialized_snapshot.subxcnt = 0;
-
 	/* Copy struct to possibly-unaligned buffer */
 	memcpy(start_address,
 		   &serialized_snapshot, sizeof(SerializedSnapshotData));
@@ -2152,10 +2144,8 @@ SerializeSnapshot(Snapshot snapshot, char *start_address)
 			   snapshot->xip, snapshot->xcnt * sizeof(TransactionId));
 
 	/*
-	 * Copy SubXID array. Don't bother to copy it if it had overflowed,
-	 * though, because it's not used anywhere in that case. Except if it's a
-	 * snapshot taken during recovery; all the top-level XIDs are in subxip as
-	 * well in that case, so we mustn't lose them.
+	 * Copy SubXID array.  We need it even if it had overflowed, see
+	 * XidInMVCCSnapshot().
 	 */
 	if (serialized_snapshot.subxcnt > 0)
 	{
@@ -2202,6 +2192,7 @@ RestoreSnapshot(char *start_address)
 	snapshot->subxip = NULL;
 	snapshot->subxcnt = serialized_snapshot.subxcnt;
 	snapshot->suboverflowed = serialized_snapshot.suboverflowed;
+	snapshot->subxoverflow_xmin = serialized_snapshot.subxoverflow_xmin;
 	snapshot->takenDuringRecovery = serialized_snapshot.takenDuringRecovery;
 	snapshot->curcid = serialized_snapshot.curcid;
 	snapshot->whenTaken = serialized_snapshot.whenTaken;
@@ -2303,19 +2294,36 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		}
 		else
 		{
+			int32		j;
+
 			/*
-			 * Snapshot overflowed, so convert xid to top-level.  This is safe
-			 * because we eliminated too-old XIDs above.
+			 * Snapshot overflowed, but subxip[] still has the subxacts of the
+			 * transactions that didn't overflow, so check those first.
 			 */
-			xid = SubTransGetTopmostTransaction(xid);
+			for (j = 0; j < snapshot->subxcnt; j++)
+			{
+				if (TransactionIdEquals(xid, snapshot->subxip[j]))
+					return true;
+			}
 
 			/*
-			 * If xid was indeed a subxact, we might now have an xid < xmin,
-			 * so recheck to avoid an array scan.  No point in rechecking
-			 * xmax.
+			 * An XID older than every overflowed transaction can't be one of
+			 * their subxacts, so it's enough to search xip[] for it.
+			 * Otherwise convert xid to top-level.  This is safe because we
+			 * eliminated too-old XIDs above.
 			 */
-			if (TransactionIdPrecedes(xid, snapshot->xmin))
-				return false;
+			if (TransactionIdFollowsOrEquals(xid, snapshot->subxoverflow_xmin))
+			{
+				xid = SubTransGetTopmostTransaction(xid);
+
+				/*
+				 * If xid was indeed a subxact, we might now have an xid <
+				 * xmin, so recheck to avoid an array scan.  No point in
+				 * rechecking xmax.
+				 */
+				if (TransactionIdPrecedes(xid, snapshot->xmin))
+					return false;
+			}
 		}
 
 		for (i = 0; i < snapshot->xcnt; i++)
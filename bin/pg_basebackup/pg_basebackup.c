@@ -43,6 +43,7 @@
 #include "streamutil.h"
 
 #define ERRCODE_DATA_CORRUPTED	"XX001"
+#define ERRCODE_SYNTAX_ERROR	"42601"
 
 typedef struct TablespaceListCell
 {
@@ -113,6 +114,11 @@ typedef void (*WriteDataCallback) (size_t nbytes, char *buf,
  */
 #define MINIMUM_VERSION_FOR_MANIFESTS	130000
 
+/*
+ * Server-side compression of the tar streams is supported from version 14.
+ */
+#define MINIMUM_VERSION_FOR_SERVER_COMPRESSION	140000
+
 /*
  * Different ways to include WAL
  */
@@ -135,6 +141,9 @@ static bool showprogress = false;
 static bool estimatesize = true;
 static int	verbose = 0;
 static int	compresslevel = 0;
+static char *server_compression = NULL;	/* method name, or NULL */
+static int	server_compresslevel = 0;
+static const char *server_compression_suffix = "";
 static IncludeWal includewal = STREAM_WAL;
 static bool fastcheckpoint = false;
 static bool writerecoveryconf = false;
@@ -394,6 +403,8 @@ usage(void)
 			 "                         include required WAL files with specified method\n"));
 	printf(_("  -z, --gzip             compress tar output\n"));
 	printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+	printf(_("      --server-compress=gzip|lz4[:LEVEL]\n"
+			 "                         compress tar output on the server\n"));
 	printf(_("\nGeneral options:\n"));
 	printf(_("  -c, --checkpoint=fast|spread\n"
 			 "                         set fast or spread checkpointing\n"));
@@ -1030,8 +1041,8 @@ writeTarData(WriteTarState *state, char *buf, int r)
  * the data from this file directly into a tar file. If compression is
  * enabled, the data will be compressed while written to the file.
  *
- * The file will be named base.tar[.gz] if it's for the main data directory
- * or <tablespaceoid>.tar[.gz] if it's for another tablespace.
+ * The file will be named base.tar[.gz|.lz4] if it's for the main data directory
+ * or <tablespaceoid>.tar[.gz|.lz4] if it's for another tablespace.
  *
  * No attempt to inspect or validate the contents of the file is done.
  */
@@ -1112,7 +1123,7 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 #endif
 			{
 				snprintf(state.filename, sizeof(state.filename),
-						 "%s/base.tar", basedir);
+						 "%s/base.tar%s", basedir, server_compression_suffix);
 				state.tarfile = fopen(state.filename, "wb");
 			}
 		}
@@ -1140,8 +1151,9 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		else
 #endif
 		{
-			snprintf(state.filename, sizeof(state.filename), "%s/%s.tar",
-					 basedir, PQgetvalue(res, rownum, 0));
+			snprintf(state.filename, sizeof(state.filename), "%s/%s.tar%s",
+					 basedir, PQgetvalue(res, rownum, 0),
+					 server_compression_suffix);
 			state.tarfile = fopen(state.filename, "wb");
 		}
 	}
@@ -1256,8 +1268,13 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		termPQExpBuffer(&buf);
 	}
 
-	/* 2 * TAR_BLOCK_SIZE bytes empty data at end of file */
-	writeTarData(&state, zerobuf, sizeof(zerobuf));
+	/*
+	 * 2 * TAR_BLOCK_SIZE bytes empty data at end of file.  A server-compressed
+	 * stream already has them inside the compressed data, and we must not
+	 * append anything after the end of the compressed stream.
+	 */
+	if (server_compression == NULL)
+		writeTarData(&state, zerobuf, sizeof(zerobuf));
 
 #ifdef HAVE_LIBZ
 	if (state.ztarfile != NULL)
@@ -1806,6 +1823,7 @@ BaseBackup(void)
 	char	   *maxrate_clause = NULL;
 	char	   *manifest_clause = NULL;
 	char	   *manifest_checksums_clause = "";
+	char	   *compression_clause = "";
 	int			i;
 	char		xlogstart[64];
 	char		xlogend[64];
@@ -1879,6 +1897,22 @@ BaseBackup(void)
 												 manifest_checksums);
 	}
 
+	if (server_compression != NULL)
+	{
+		if (serverVersion < MINIMUM_VERSION_FOR_SERVER_COMPRESSION)
+		{
+			pg_log_error("server does not support server-side compression");
+			exit(1);
+		}
+		if (server_compresslevel != 0)
+			compression_clause = psprintf("COMPRESSION '%s' COMPRESSION_LEVEL %d",
+										  server_compression,
+										  server_compresslevel);
+		else
+			compression_clause = psprintf("COMPRESSION '%s'",
+										  server_compression);
+	}
+
 	if (verbose)
 		pg_log_info("initiating base backup, waiting for checkpoint to complete");
 
@@ -1892,7 +1926,7 @@ BaseBackup(void)
 	}
 
 	basebkp =
-		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s %s",
+		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s %s %s",
 				 escaped_label,
 				 estimatesize ? "PROGRESS" : "",
 				 includewal == FETCH_WAL ? "WAL" : "",
@@ -1902,7 +1936,8 @@ BaseBackup(void)
 				 format == 't' ? "TABLESPACE_MAP" : "",
 				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS",
 				 manifest_clause ? manifest_clause : "",
-				 manifest_checksums_clause);
+				 manifest_checksums_clause,
+				 compression_clause);
 
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
@@ -1917,8 +1952,19 @@ BaseBackup(void)
 	res = PQgetResult(conn);
 	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
-		pg_log_error("could not initiate base backup: %s",
-					 PQerrorMessage(conn));
+		const char *sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+
+		/*
+		 * A version 14 server built without server-side compression support
+		 * doesn't know the COMPRESSION option, and can only report a syntax
+		 * error.
+		 */
+		if (server_compression != NULL && sqlstate &&
+			strcmp(sqlstate, ERRCODE_SYNTAX_ERROR) == 0)
+			pg_log_error("server does not support server-side compression");
+		else
+			pg_log_error("could not initiate base backup: %s",
+						 PQerrorMessage(conn));
 		exit(1);
 	}
 	if (PQntuples(res) != 1)
@@ -2258,6 +2304,7 @@ main(int argc, char **argv)
 		{"no-manifest", no_argument, NULL, 5},
 		{"manifest-force-encode", no_argument, NULL, 6},
 		{"manifest-checksums", required_argument, NULL, 7},
+		{"server-compress", required_argument, NULL, 8},
 		{NULL, 0, NULL, 0}
 	};
 	int			c;
@@ -2438,6 +2485,36 @@ main(int argc, char **argv)
 			case 7:
 				manifest_checksums = pg_strdup(optarg);
 				break;
+			case 8:
+				{
+					char	   *sep;
+
+					server_compression = pg_strdup(optarg);
+					sep = strchr(server_compression, ':');
+					if (sep != NULL)
+					{
+						*sep = '\0';
+						server_compresslevel = atoi(sep + 1);
+						if (server_compresslevel <= 0)
+						{
+							pg_log_error("invalid compression level \"%s\"",
+										 sep + 1);
+							exit(1);
+						}
+					}
+
+					if (strcmp(server_compression, "gzip") == 0)
+						server_compression_suffix = ".gz";
+					else if (strcmp(server_compression, "lz4") == 0)
+						server_compression_suffix = ".lz4";
+					else
+					{
+						pg_log_error("invalid compression method \"%s\", must be \"gzip\" or \"lz4\"",
+									 server_compression);
+						exit(1);
+					}
+				}
+				break;
 			default:
 
 				/*
@@ -2483,6 +2560,47 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (server_compression != NULL)
+	{
+		if (format != 't')
+		{
+			pg_log_error("only tar mode backups can be compressed");
+			fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+					progname);
+			exit(1);
+		}
+
+		if (compresslevel != 0)
+		{
+			pg_log_error("%s and %s are incompatible options",
+						 "--server-compress", "--compress");
+			fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+					progname);
+			exit(1);
+		}
+
+		/*
+		 * The recovery configuration and, when writing to stdout, the backup
+		 * manifest are injected into the tar stream on the client side, which
+		 * is not possible once the server has compressed it.
+		 */
+		if (writerecoveryconf)
+		{
+			pg_log_error("%s and %s are incompatible options",
+						 "--server-compress", "--write-recovery-conf");
+			fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+					progname);
+			exit(1);
+		}
+
+		if (strcmp(basedir, "-") == 0 && manifest)
+		{
+			pg_log_error("cannot write a server-compressed backup with a manifest to stdout");
+			pg_log_info("HINT: use --no-manifest, or write the backup to a directory");
+			exit(1);
+		}
+	}
+
 	if (format == 't' && includewal == STREAM_WAL && strcmp(basedir, "-") == 0)
 	{
 		pg_log_error("cannot stream write-ahead logs in tar mode to stdout");
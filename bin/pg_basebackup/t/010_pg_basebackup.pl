@@ -7,9 +7,10 @@ use Cwd;
 use Config;
 use File::Basename qw(basename dirname);
 use File::Path qw(rmtree);
+use IO::Uncompress::Gunzip qw(gunzip);
 use PostgresNode;
 use TestLib;
-use Test::More tests => 110;
+use Test::More tests => 118;
 
 program_help_ok('pg_basebackup');
 program_version_ok('pg_basebackup');
@@ -180,6 +181,71 @@ $node->command_ok([ 'pg_basebackup', '-D', "$tempdir/tarbackup", '-Ft' ],
 ok(-f "$tempdir/tarbackup/base.tar", 'backup tar was created');
 rmtree("$tempdir/tarbackup");
 
+# Server-side compression.  Check that the compressed streams decompress
+# to a tar archive that the tar program can read.
+SKIP:
+{
+	my $tar = $ENV{TAR};
+	skip "postgres not built with zlib support", 4
+	  if (!check_pg_config("#define HAVE_LIBZ 1"));
+
+	$node->command_ok(
+		[
+			'pg_basebackup',   '-D', "$tempdir/tarbackup_gz", '-Ft',
+			'--server-compress=gzip'
+		],
+		'tar format with server-side gzip compression');
+	ok(-f "$tempdir/tarbackup_gz/base.tar.gz",
+		'gzip-compressed tar was created');
+	ok( gunzip(
+			"$tempdir/tarbackup_gz/base.tar.gz" =>
+			  "$tempdir/tarbackup_gz/base.tar"
+		),
+		'gzip-compressed tar decompresses');
+  SKIP:
+	{
+		skip "no tar program available", 1
+		  if (!defined $tar || $tar eq '');
+
+		$node->command_ok([ $tar, 'tf', "$tempdir/tarbackup_gz/base.tar" ],
+			'gzip-decompressed tar is valid');
+	}
+	rmtree("$tempdir/tarbackup_gz");
+}
+
+SKIP:
+{
+	my $tar = $ENV{TAR};
+	my $lz4 = $ENV{LZ4};
+	skip "postgres not built with LZ4 support", 4
+	  if (!check_pg_config("#define USE_LZ4 1"));
+	skip "no tar or lz4 program available", 4
+	  if (!defined $tar
+		|| $tar eq ''
+		|| !defined $lz4
+		|| $lz4 eq ''
+		|| system_log($lz4, '--version') != 0);
+
+	$node->command_ok(
+		[
+			'pg_basebackup',   '-D', "$tempdir/tarbackup_lz4", '-Ft',
+			'--server-compress=lz4:1'
+		],
+		'tar format with server-side lz4 compression');
+	ok(-f "$tempdir/tarbackup_lz4/base.tar.lz4",
+		'lz4-compressed tar was created');
+	$node->command_ok(
+		[
+			$lz4, '-d', '-f',
+			"$tempdir/tarbackup_lz4/base.tar.lz4",
+			"$tempdir/tarbackup_lz4/base.tar"
+		],
+		'lz4-compressed tar decompresses');
+	$node->command_ok([ $tar, 'tf', "$tempdir/tarbackup_lz4/base.tar" ],
+		'lz4-decompressed tar is valid');
+	rmtree("$tempdir/tarbackup_lz4");
+}
+
 $node->command_fails(
 	[ 'pg_basebackup', '-D', "$tempdir/backup_foo", '-Fp', "-T=/foo" ],
 	'-T with empty old directory fails');
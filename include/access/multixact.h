@@ -30,8 +30,8 @@
 #define MaxMultiXactOffset	((MultiXactOffset) 0xFFFFFFFF)
 
 /* Number of SLRU buffers to use for multixact */
-#define NUM_MULTIXACTOFFSET_BUFFERS		8
-#define NUM_MULTIXACTMEMBER_BUFFERS		16
+extern int	multixact_offset_buffers;
+extern int	multixact_member_buffers;
 
 /*
  * Possible multixact lock modes ("status").  The first four modes are for
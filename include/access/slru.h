@@ -33,6 +33,16 @@
  */
 #define SLRU_PAGES_PER_SEGMENT	32
 
+/*
+ * The buffer slots of an SLRU are divided into banks of about this many
+ * slots.  A page can only be cached in the bank selected by its page number,
+ * so lookups and victim selection only need to scan one bank.
+ */
+#define SLRU_BANK_SIZE			16
+
+/* Upper limit for the configurable SLRU sizes: 1GB worth of buffers */
+#define SLRU_MAX_ALLOWED_BUFFERS ((1024 * 1024 * 1024) / BLCKSZ)
+
 /*
  * Page status codes.  Note that these do not include the "dirty" bit.
  * page_dirty can be true only in the VALID or WRITE_IN_PROGRESS states;
@@ -52,11 +62,18 @@ typedef enum
  */
 typedef struct SlruSharedData
 {
+	/*
+	 * Lock protecting the shared state of all the banks, or NULL if each bank
+	 * has its own lock in bank_locks[].
+	 */
 	LWLock	   *ControlLock;
 
 	/* Number of buffers managed by this SLRU structure */
 	int			num_slots;
 
+	/* Number of banks the buffers are divided into; see SlruBankStart() */
+	int			num_banks;
+
 	/*
 	 * Arrays holding info for each buffer slot.  Page number is undefined
 	 * when status is EMPTY, as is page_lru_count.
@@ -68,6 +85,13 @@ typedef struct SlruSharedData
 	int		   *page_lru_count;
 	LWLockPadded *buffer_locks;
 
+	/*
+	 * Per-bank locks, each protecting the shared state of its bank's slots,
+	 * or NULL if ControlLock is used for all banks.  Use
+	 * SimpleLruGetBankLock() to find the lock covering a given page.
+	 */
+	LWLockPadded *bank_locks;
+
 	/*
 	 * Optional array of WAL flush LSNs associated with entries in the SLRU
 	 * pages.  If not zero/NULL, we must flush WAL before writing pages (true
@@ -80,22 +104,25 @@ typedef struct SlruSharedData
 	int			lsn_groups_per_page;
 
 	/*----------
-	 * We mark a page "most recently used" by setting
-	 *		page_lru_count[slotno] = ++cur_lru_count;
-	 * The oldest page is therefore the one with the highest value of
-	 *		cur_lru_count - page_lru_count[slotno]
+	 * Each bank keeps its own LRU counter.  We mark a page "most recently
+	 * used" by setting
+	 *		page_lru_count[slotno] = ++bank_cur_lru_count[bankno];
+	 * The oldest page in a bank is therefore the one with the highest value
+	 * of
+	 *		bank_cur_lru_count[bankno] - page_lru_count[slotno]
 	 * The counts will eventually wrap around, but this calculation still
 	 * works as long as no page's age exceeds INT_MAX counts.
 	 *----------
 	 */
-	int			cur_lru_count;
+	int		   *bank_cur_lru_count;
 
 	/*
 	 * latest_page_number is the page number of the current end of the log;
 	 * this is not critical data, since we use it only to avoid swapping out
-	 * the latest page.
+	 * the latest page.  It is atomic because it is set and read while
+	 * holding the locks of different banks.
 	 */
-	int			latest_page_number;
+	pg_atomic_uint32 latest_page_number;
 
 	/* SLRU's index for statistics purposes (might not be unique) */
 	int			slru_stats_idx;
@@ -139,10 +166,12 @@ typedef struct SlruCtlData
 typedef SlruCtlData *SlruCtl;
 
 
+extern int	SimpleLruAutotuneBuffers(int divisor, int max);
 extern Size SimpleLruShmemSize(int nslots, int nlsns);
 extern void SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 						  LWLock *ctllock, const char *subdir, int tranche_id,
-						  SyncRequestHandler sync_handler);
+						  int bank_tranche_id, SyncRequestHandler sync_handler);
+extern LWLock *SimpleLruGetBankLock(SlruCtl ctl, int pageno);
 extern int	SimpleLruZeroPage(SlruCtl ctl, int pageno);
 extern int	SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 							  TransactionId xid);
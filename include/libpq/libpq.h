@@ -81,6 +81,8 @@ extern int	pq_peekbyte(void);
 extern int	pq_getbyte_if_available(unsigned char *c);
 extern bool pq_buffer_has_data(void);
 extern int	pq_putmessage_v2(char msgtype, const char *s, size_t len);
+extern bool pq_putmessage_file_noblock(char msgtype, const char *s, size_t len,
+									   int fd, off_t offset, size_t filelen);
 extern bool pq_check_connection(void);
 
 /*
@@ -109,6 +111,15 @@ extern ssize_t secure_write(Port *port, void *ptr, size_t len);
 extern ssize_t secure_raw_read(Port *port, void *ptr, size_t len);
 extern ssize_t secure_raw_write(Port *port, const void *ptr, size_t len);
 
+/*
+ * On platforms with sendfile(), file contents can be sent over unencrypted
+ * connections without copying them through user space.
+ */
+#if defined(__linux__)
+#define PQ_HAVE_SENDFILE 1
+extern ssize_t secure_sendfile(Port *port, int fd, off_t offset, size_t len);
+#endif
+
 /*
  * prototypes for functions in be-secure-gssapi.c
  */
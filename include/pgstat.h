@@ -73,6 +73,7 @@ typedef enum StatMsgType
 	PGSTAT_MTYPE_BGWRITER,
 	PGSTAT_MTYPE_WAL,
 	PGSTAT_MTYPE_SLRU,
+	PGSTAT_MTYPE_LWLOCK,
 	PGSTAT_MTYPE_FUNCSTAT,
 	PGSTAT_MTYPE_FUNCPURGE,
 	PGSTAT_MTYPE_RECOVERYCONFLICT,
@@ -137,7 +138,8 @@ typedef enum PgStat_Shared_Reset_Target
 {
 	RESET_ARCHIVER,
 	RESET_BGWRITER,
-	RESET_WAL
+	RESET_WAL,
+	RESET_LWLOCK
 } PgStat_Shared_Reset_Target;
 
 /* Possible object types for resetting single counters */
@@ -502,6 +504,38 @@ typedef struct PgStat_MsgSLRU
 	PgStat_Counter m_truncate;
 } PgStat_MsgSLRU;
 
+/* ----------
+ * PgStat_LWLockEntry			Per-tranche LWLock contention counts
+ *
+ * t_index is the tranche ID, except that all extension tranches are counted
+ * under LWTRANCHE_FIRST_USER_DEFINED.
+ * ----------
+ */
+typedef struct PgStat_LWLockEntry
+{
+	int			t_index;
+	PgStat_Counter t_acquisitions;	/* LWLockAcquire and friends calls */
+	PgStat_Counter t_waits;		/* times we had to sleep on the lock */
+	PgStat_Counter t_spins;		/* spin iterations before acquiring or
+								 * queueing */
+	PgStat_Counter t_wait_time; /* time spent sleeping, in microseconds */
+} PgStat_LWLockEntry;
+
+/* ----------
+ * PgStat_MsgLWLock			Sent by a backend to update LWLock statistics.
+ * ----------
+ */
+#define PGSTAT_NUM_LWLOCKENTRIES	\
+	((PGSTAT_MSG_PAYLOAD - sizeof(int))  \
+	 / sizeof(PgStat_LWLockEntry))
+
+typedef struct PgStat_MsgLWLock
+{
+	PgStat_MsgHdr m_hdr;
+	int			m_nentries;
+	PgStat_LWLockEntry m_entry[PGSTAT_NUM_LWLOCKENTRIES];
+} PgStat_MsgLWLock;
+
 /* ----------
  * PgStat_MsgReplSlot	Sent by a backend or a wal sender to update replication
  *						slot statistics.
@@ -691,6 +725,7 @@ typedef union PgStat_Msg
 	PgStat_MsgBgWriter msg_bgwriter;
 	PgStat_MsgWal msg_wal;
 	PgStat_MsgSLRU msg_slru;
+	PgStat_MsgLWLock msg_lwlock;
 	PgStat_MsgFuncstat msg_funcstat;
 	PgStat_MsgFuncpurge msg_funcpurge;
 	PgStat_MsgRecoveryConflict msg_recoveryconflict;
@@ -711,7 +746,7 @@ typedef union PgStat_Msg
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BCA2
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BCA3
 
 /* ----------
  * PgStat_StatDBEntry			The collector's data per database
@@ -881,6 +916,18 @@ typedef struct PgStat_SLRUStats
 	TimestampTz stat_reset_timestamp;
 } PgStat_SLRUStats;
 
+/*
+ * LWLock statistics kept in the stats collector, one per tranche
+ */
+typedef struct PgStat_LWLockStats
+{
+	PgStat_Counter acquisitions;
+	PgStat_Counter waits;
+	PgStat_Counter spins;
+	PgStat_Counter wait_time;	/* in microseconds */
+	TimestampTz stat_reset_timestamp;
+} PgStat_LWLockStats;
+
 /*
  * Replication slot statistics kept in the stats collector
  */
@@ -936,6 +983,12 @@ extern PgStat_MsgBgWriter BgWriterStats;
  */
 extern PgStat_MsgWal WalStats;
 
+/*
+ * LWLock statistics counters are updated directly by lwlock.c, indexed by
+ * tranche (see NUM_LWLOCK_STATS_TRANCHES)
+ */
+extern PgStat_LWLockEntry PendingLWLockStats[];
+
 /*
  * Updated by pgstat_count_buffer_*_time macros
  */
@@ -1082,6 +1135,7 @@ extern void pgstat_twophase_postabort(TransactionId xid, uint16 info,
 extern void pgstat_send_archiver(const char *xlog, bool failed);
 extern void pgstat_send_bgwriter(void);
 extern void pgstat_send_wal(bool force);
+extern void pgstat_send_lwlock(bool force);
 
 /* ----------
  * Support functions for the SQL-callable functions to
@@ -1095,6 +1149,7 @@ extern PgStat_ArchiverStats *pgstat_fetch_stat_archiver(void);
 extern PgStat_GlobalStats *pgstat_fetch_global(void);
 extern PgStat_WalStats *pgstat_fetch_stat_wal(void);
 extern PgStat_SLRUStats *pgstat_fetch_slru(void);
+extern PgStat_LWLockStats *pgstat_fetch_lwlock(void);
 extern PgStat_StatReplSlotEntry *pgstat_fetch_replslot(NameData slotname);
 
 extern void pgstat_count_slru_page_zeroed(int slru_idx);
@@ -0,0 +1,27 @@
+/*-------------------------------------------------------------------------
+ *
+ * autoprewarm.h
+ *	  Exports from postmaster/autoprewarm.c.
+ *
+ * Portions Copyright (c) 1996-2021, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/postmaster/autoprewarm.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef _AUTOPREWARM_H
+#define _AUTOPREWARM_H
+
+/* GUC options */
+extern bool autoprewarm;
+extern int	autoprewarm_interval;
+
+extern Size AutoPrewarmShmemSize(void);
+extern void AutoPrewarmShmemInit(void);
+extern void AutoPrewarmRegister(void);
+
+extern void AutoPrewarmMain(Datum main_arg) pg_attribute_noreturn();
+extern void AutoPrewarmDatabaseMain(Datum main_arg);
+
+#endif							/* _AUTOPREWARM_H */
@@ -0,0 +1,33 @@
+/*-------------------------------------------------------------------------
+ *
+ * backup_compress.h
+ *	  Routines for compressing a base backup's tar streams on the server.
+ *
+ * Portions Copyright (c) 2010-2021, PostgreSQL Global Development Group
+ *
+ * src/include/replication/backup_compress.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef BACKUP_COMPRESS_H
+#define BACKUP_COMPRESS_H
+
+typedef enum backup_compression_type
+{
+	BACKUP_COMPRESSION_NONE,
+	BACKUP_COMPRESSION_GZIP,
+	BACKUP_COMPRESSION_LZ4
+} backup_compression_type;
+
+typedef struct backup_compress_state backup_compress_state;
+
+extern bool ParseBackupCompressionType(const char *name,
+									   backup_compression_type *type);
+extern backup_compress_state *BeginBackupCompression(backup_compression_type type,
+													 int level);
+extern void BackupCompressData(backup_compress_state *state,
+							   const char *data, size_t len);
+extern void EndBackupCompression(backup_compress_state *state);
+extern void AbortBackupCompression(backup_compress_state *state);
+
+#endif
@@ -18,6 +18,15 @@
 #include "utils/timestamp.h"
 
 extern PGDLLIMPORT int logical_decoding_work_mem;
+extern PGDLLIMPORT int logical_decoding_spill_compression;
+
+/* compression methods for changes spilled to disk */
+typedef enum ReorderBufferSpillCompression
+{
+	SPILL_COMPRESSION_NONE = 0,
+	SPILL_COMPRESSION_PGLZ,
+	SPILL_COMPRESSION_LZ4
+} ReorderBufferSpillCompression;
 
 /* an individual tuple, stored in one chunk of memory */
 typedef struct ReorderBufferTupleBuf
@@ -586,6 +595,15 @@ struct ReorderBuffer
 	char	   *outbuf;
 	Size		outbufsize;
 
+	/* block of serialized changes not yet written to disk */
+	char	   *spillbuf;
+	Size		spillbufsize;
+	Size		spillbuflen;
+
+	/* buffer for compressing spilled blocks */
+	char	   *compbuf;
+	Size		compbufsize;
+
 	/* memory accounting */
 	Size		size;
 
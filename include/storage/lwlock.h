@@ -130,6 +130,7 @@ extern void CreateLWLocks(void);
 extern void InitLWLockAccess(void);
 
 extern const char *GetLWLockIdentifier(uint32 classId, uint16 eventId);
+extern const char *GetLWLockStatsTrancheName(int index);
 
 /*
  * Extensions (or core code) can obtain an LWLocks by calling
@@ -189,9 +190,18 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_SHARED_TIDBITMAP,
 	LWTRANCHE_PARALLEL_APPEND,
 	LWTRANCHE_PER_XACT_PREDICATE_LIST,
+	LWTRANCHE_RELSIZE_CACHE,
+	LWTRANCHE_SUBTRANS_SLRU,
+	LWTRANCHE_MULTIXACTOFFSET_SLRU,
 	LWTRANCHE_FIRST_USER_DEFINED
 }			BuiltinTrancheIds;
 
+/*
+ * Contention statistics are kept for each built-in tranche, plus one entry
+ * that all extension tranches are counted in.
+ */
+#define NUM_LWLOCK_STATS_TRANCHES	(LWTRANCHE_FIRST_USER_DEFINED + 1)
+
 /*
  * Prior to PostgreSQL 9.4, we used an enum type called LWLockId to refer
  * to LWLocks.  New code should instead use LWLock *.  However, for the
@@ -45,6 +45,7 @@ typedef struct PGShmemHeader	/* standard header for all Postgres shmem */
 extern int	shared_memory_type;
 extern int	huge_pages;
 extern int	huge_page_size;
+extern bool shared_memory_numa_interleave;
 
 /* Possible values for huge_pages */
 typedef enum
@@ -87,5 +88,6 @@ extern PGShmemHeader *PGSharedMemoryCreate(Size size,
 										   PGShmemHeader **shim);
 extern bool PGSharedMemoryIsInUse(unsigned long id1, unsigned long id2);
 extern void PGSharedMemoryDetach(void);
+extern void PGSharedMemoryInterleave(void *address, Size size, int elevel);
 
 #endif							/* PG_SHMEM_H */
@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * relsize.h
+ *	  Shared cache of relation fork sizes.
+ *
+ * Portions Copyright (c) 1996-2021, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/relsize.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef RELSIZE_H
+#define RELSIZE_H
+
+#include "storage/block.h"
+#include "storage/relfilenode.h"
+
+/* GUC variable */
+extern int	relsize_cache_entries;
+
+extern Size RelSizeShmemSize(void);
+extern void RelSizeShmemInit(void);
+
+extern BlockNumber RelSizeCacheLookup(RelFileNode rnode, ForkNumber forknum,
+									  uint64 *generation);
+extern void RelSizeCacheInsert(RelFileNode rnode, ForkNumber forknum,
+							   BlockNumber nblocks, uint64 generation);
+extern void RelSizeCacheExtend(RelFileNode rnode, ForkNumber forknum,
+							   BlockNumber nblocks);
+extern void RelSizeCacheSet(RelFileNode rnode, ForkNumber forknum,
+							BlockNumber nblocks);
+extern void RelSizeCacheForget(RelFileNode rnode, ForkNumber forknum);
+extern void RelSizeCacheForgetDatabase(Oid dbid);
+extern void RelSizeCacheForgetAll(void);
+
+#endif							/* RELSIZE_H */
@@ -181,6 +181,16 @@ typedef struct SnapshotData
 	int32		subxcnt;		/* # of xact ids in subxip[] */
 	bool		suboverflowed;	/* has the subxip array overflowed? */
 
+	/*
+	 * If suboverflowed, subxip[] still holds the subxact IDs of transactions
+	 * whose subxid cache did not overflow, and this is the oldest top-level
+	 * XID of a transaction whose cache did.  Subxacts are always newer than
+	 * their parent, so an XID older than this that is not in subxip[] is not
+	 * a running subxact, and needs no pg_subtrans lookup.  Set to xmin when
+	 * nothing better is known.
+	 */
+	TransactionId subxoverflow_xmin;
+
 	bool		takenDuringRecovery;	/* recovery-shaped snapshot? */
 	bool		copied;			/* false if it's a static snapshot */
 
@@ -0,0 +1,69 @@
+# Visibility checks against a transaction whose subxid cache has overflowed.
+#
+# s1 has a few subtransactions, which stay in the snapshots' subxip arrays.
+# s2 opens more than PGPROC_MAX_CACHED_SUBXIDS (64) subtransactions, aborting
+# some of them, so snapshots taken while it runs are marked overflowed.  s1's
+# XIDs are older than s2's, so they are handled without pg_subtrans, while
+# s2's subxids have to be looked up there.  s3 reads with a parallel query,
+# so the overflowed snapshot is serialized for the workers; s4 reads without
+# one.
+
+setup
+{
+	CREATE TABLE subxids (a int);
+	ALTER TABLE subxids SET (parallel_workers = 2);
+}
+
+teardown
+{
+	DROP TABLE subxids;
+}
+
+session s1
+setup		{ BEGIN; }
+step s1ins	{ INSERT INTO subxids VALUES (-1); SAVEPOINT a; INSERT INTO subxids VALUES (-2); SAVEPOINT b; INSERT INTO subxids VALUES (-3); ROLLBACK TO b; }
+step s1c	{ COMMIT; }
+
+session s2
+setup		{ BEGIN; }
+step s2ins
+{
+	DO $$
+	BEGIN
+		FOR i IN 1..100 LOOP
+			BEGIN
+				INSERT INTO subxids VALUES (i);
+				IF i % 10 = 0 THEN
+					RAISE EXCEPTION 'abort subtransaction';
+				END IF;
+			EXCEPTION WHEN raise_exception THEN
+				NULL;
+			END;
+		END LOOP;
+	END $$;
+}
+step s2c	{ COMMIT; }
+step s2a	{ ROLLBACK; }
+
+session s3
+setup
+{
+	SET parallel_setup_cost = 0;
+	SET parallel_tuple_cost = 0;
+	SET min_parallel_table_scan_size = 0;
+	SET parallel_leader_participation = off;
+}
+step s3b	{ BEGIN ISOLATION LEVEL REPEATABLE READ; SELECT count(*) AS n, coalesce(sum(a), 0) AS total FROM subxids; }
+step s3r	{ SELECT count(*) AS n, coalesce(sum(a), 0) AS total FROM subxids; }
+step s3c	{ COMMIT; }
+
+session s4
+setup		{ SET max_parallel_workers_per_gather = 0; }
+step s4r	{ SELECT count(*) AS n, coalesce(sum(a), 0) AS total FROM subxids; }
+
+# both writers still running when the snapshots are taken
+permutation s1ins s2ins s3b s4r s1c s2c s3r s4r s3c
+# the non-overflowed writer commits before the snapshot
+permutation s1ins s2ins s1c s3b s4r s2c s3r s4r s3c
+# the overflowed writer aborts
+permutation s1ins s2ins s3b s2a s1c s3r s4r s3c
@@ -0,0 +1,63 @@
+# Copyright (c) 2021, PostgreSQL Global Development Group
+
+# Exercise bulk extension of heap relations.  When backends queue up on the
+# relation extension lock, the one holding it extends the relation by many
+# blocks at once, without passing them through shared buffers.  Depending on
+# the number of blocks, the new space is either allocated with
+# posix_fallocate() or written out as zeroes.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+
+my $node = get_new_node('primary');
+$node->init();
+$node->append_conf('postgresql.conf', 'autovacuum = off');
+$node->start;
+
+$node->safe_psql('postgres',
+	'CREATE TABLE bulk_ext (id int, filler text) WITH (fillfactor = 50)');
+
+# Many clients inserting at once make them wait for each other on the
+# extension lock, which is what triggers bulk extension.
+$node->pgbench(
+	'--no-vacuum --client=10 --jobs=10 --transactions=100',
+	0,
+	[qr{processed: 1000/1000}],
+	[qr{^$}],
+	'concurrent insertions',
+	{
+		'002_bulk_extension_insert' =>
+		  "INSERT INTO bulk_ext SELECT g, repeat('x', 400) FROM generate_series(1, 40) g;"
+	});
+
+is($node->safe_psql('postgres', 'SELECT count(*) FROM bulk_ext'),
+	'40000', 'all rows inserted');
+
+# No page may lie beyond the size the relation reports, and the blocks added
+# in bulk must be usable once VACUUM has gone through them.
+is( $node->safe_psql(
+		'postgres',
+		"SELECT max((ctid::text::point)[0]) < pg_relation_size('bulk_ext') / current_setting('block_size')::int FROM bulk_ext"
+	),
+	't',
+	'all tuples within the relation size');
+$node->safe_psql('postgres', 'VACUUM bulk_ext');
+$node->safe_psql('postgres',
+	"INSERT INTO bulk_ext SELECT g, repeat('x', 400) FROM generate_series(1, 1000) g"
+);
+is($node->safe_psql('postgres', 'SELECT count(*) FROM bulk_ext'),
+	'41000', 'rows inserted after VACUUM');
+
+# Crash recovery must cope with the pre-extended, uninitialized pages.
+$node->stop('immediate');
+$node->start;
+is($node->safe_psql('postgres', 'SELECT count(*) FROM bulk_ext'),
+	'41000', 'rows intact after crash recovery');
+$node->safe_psql('postgres', 'VACUUM bulk_ext');
+is($node->safe_psql('postgres', 'SELECT count(*) FROM bulk_ext'),
+	'41000', 'rows intact after VACUUM following crash recovery');
+
+$node->stop;
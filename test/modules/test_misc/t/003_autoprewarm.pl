@@ -0,0 +1,77 @@
+# Copyright (c) 2021, PostgreSQL Global Development Group
+
+# Test the built-in autoprewarm: the blocks in shared buffers are dumped to
+# pg_autoprewarm.blocks at shutdown, and loaded back exactly once after the
+# next start.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+use Time::HiRes qw(usleep);
+
+my $prewarmed_re =
+  qr/autoprewarm successfully prewarmed (\d+) of (\d+) previously-loaded blocks/;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+autoprewarm = on
+autoprewarm_interval = 0
+autovacuum = off
+});
+$node->start;
+
+my $dumpfile = $node->data_dir . '/pg_autoprewarm.blocks';
+
+# Small enough to be read through shared buffers rather than a ring buffer
+$node->safe_psql('postgres',
+	"CREATE TABLE apw AS SELECT g AS id, repeat('x', 100) AS filler FROM generate_series(1, 20000) g"
+);
+$node->safe_psql('postgres', 'SELECT count(*) FROM apw');
+
+# With autoprewarm_interval = 0, the file is only written at shutdown
+ok(!-e $dumpfile, 'no dump file before shutdown');
+$node->stop;
+ok(-s $dumpfile, 'dump file written at shutdown');
+
+my $log_offset = -s $node->logfile;
+$node->start;
+$log_offset = $node->wait_for_log($prewarmed_re, $log_offset);
+
+my ($loaded) = slurp_file($node->logfile) =~ $prewarmed_re;
+cmp_ok($loaded, '>', 0, 'blocks were prewarmed after restart');
+
+# The table's blocks must all be found in shared buffers now
+my $explain = $node->safe_psql('postgres',
+	'EXPLAIN (ANALYZE, BUFFERS, COSTS OFF, TIMING OFF, SUMMARY OFF) SELECT * FROM apw'
+);
+my ($scan_buffers) = $explain =~ /^Seq Scan on apw.*\n\s*(Buffers: .*)$/m;
+like($scan_buffers, qr/^Buffers: shared hit=\d+/,
+	'table found in prewarmed buffers');
+unlike($scan_buffers, qr/read=/, 'no table blocks read from disk');
+
+# Let the leader dump periodically, and make sure that doesn't make it load
+# the file again.
+my $mtime = (stat $dumpfile)[9];
+$node->safe_psql('postgres', 'ALTER SYSTEM SET autoprewarm_interval = 1');
+$node->reload;
+my $attempts = 10 * $TestLib::timeout_default;
+while ((stat $dumpfile)[9] == $mtime && $attempts-- > 0)
+{
+	usleep(100_000);
+}
+isnt((stat $dumpfile)[9], $mtime, 'dump file rewritten periodically');
+
+my @loads = slurp_file($node->logfile) =~ /$prewarmed_re/g;
+is(scalar(@loads) / 2, 1, 'dump file loaded only once per start');
+
+# Another restart loads the periodically written file
+$node->restart;
+$node->wait_for_log($prewarmed_re, $log_offset);
+@loads = slurp_file($node->logfile) =~ /$prewarmed_re/g;
+is(scalar(@loads) / 2, 2, 'dump file loaded again after the next restart');
+
+$node->stop;
@@ -0,0 +1,72 @@
+# Copyright (c) 2021, PostgreSQL Global Development Group
+
+# Check that logical decoding output is unaffected by compressing the
+# changes it spills to disk.
+#
+# This lives here rather than in contrib/test_decoding because the set of
+# available compression methods depends on the build.
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+my @methods = ('pglz');
+push @methods, 'lz4' if check_pg_config("#define USE_LZ4 1");
+
+plan tests => 2 * scalar(@methods);
+
+my $node = get_new_node('primary');
+$node->init(allows_streaming => 1);
+$node->append_conf(
+	'postgresql.conf', qq(
+wal_level = logical
+logical_decoding_work_mem = 64kB
+));
+$node->start;
+
+$node->safe_psql('postgres',
+	'CREATE TABLE spill_test(id integer, data text)');
+
+# One slot per method, plus one decoding without compression as reference
+foreach my $slot ('off', @methods)
+{
+	$node->safe_psql('postgres',
+		"SELECT pg_create_logical_replication_slot('spill_$slot', 'test_decoding')"
+	);
+}
+
+# A transaction whose changes are well past logical_decoding_work_mem
+$node->safe_psql('postgres',
+	"INSERT INTO spill_test SELECT g, repeat(md5(g::text), 10) FROM generate_series(1, 20000) g"
+);
+
+sub decode
+{
+	my ($slot, $method) = @_;
+
+	return $node->safe_psql(
+		'postgres', qq[
+		SET logical_decoding_spill_compression = $method;
+		SELECT count(*), md5(string_agg(data, E'\\n'))
+		FROM pg_logical_slot_get_changes('$slot', NULL, NULL,
+										 'include-xids', '0');
+	]);
+}
+
+my $expected = decode('spill_off', 'off');
+
+foreach my $method (@methods)
+{
+	is(decode("spill_$method", $method),
+		$expected, "decoding with $method-compressed spill files");
+
+	# Make sure the transaction really went through the spill files
+	ok( $node->poll_query_until(
+			'postgres',
+			"SELECT spill_txns > 0 FROM pg_stat_replication_slots WHERE slot_name = 'spill_$method'"
+		),
+		"changes spilled to disk with $method");
+}
+
+$node->stop;
@@ -0,0 +1,94 @@
+# Copyright (c) 2021, PostgreSQL Global Development Group
+
+# Check that the shared relation size cache follows extension, truncation,
+# DROP and CREATE DATABASE, on a primary and while replaying them on a
+# standby.  A stale cached size shows up as missing rows or as errors about
+# blocks that can't be read.
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 10;
+
+my $node_primary = get_new_node('primary');
+$node_primary->init(allows_streaming => 1);
+$node_primary->append_conf('postgresql.conf', 'autovacuum = off');
+$node_primary->start;
+$node_primary->backup('backup');
+
+my $node_standby = get_new_node('standby');
+$node_standby->init_from_backup($node_primary, 'backup',
+	has_streaming => 1);
+$node_standby->start;
+
+# Check the row count on both nodes, after the standby has caught up.  The
+# sequential scans read as many blocks as the cached size says.
+sub check_count
+{
+	my ($dbname, $table, $expected, $test_name) = @_;
+
+	$node_primary->wait_for_catchup($node_standby, 'replay',
+		$node_primary->lsn('insert'));
+
+	my $query = "SELECT count(*) FROM $table";
+	my $result = $node_primary->safe_psql($dbname, $query) . ','
+	  . $node_standby->safe_psql($dbname, $query);
+	is($result, "$expected,$expected", $test_name);
+	return;
+}
+
+# Extension
+$node_primary->safe_psql('postgres',
+	'CREATE TABLE relsize_test AS SELECT g AS id FROM generate_series(1, 10000) g'
+);
+check_count('postgres', 'relsize_test', 10000, 'rows after creation');
+$node_primary->safe_psql('postgres',
+	'INSERT INTO relsize_test SELECT g FROM generate_series(10001, 20000) g');
+check_count('postgres', 'relsize_test', 20000, 'rows after extension');
+
+# Truncation by VACUUM, with the old size cached on both nodes, followed by
+# extension past the old end.
+$node_primary->safe_psql('postgres',
+	'DELETE FROM relsize_test WHERE id > 5000; VACUUM relsize_test');
+check_count('postgres', 'relsize_test', 5000, 'rows after truncation');
+$node_primary->safe_psql('postgres',
+	'INSERT INTO relsize_test SELECT g FROM generate_series(5001, 30000) g');
+check_count('postgres', 'relsize_test', 30000,
+	'rows after extension past the truncated end');
+
+# TRUNCATE assigns a new relfilenode, DROP removes it.
+$node_primary->safe_psql('postgres',
+	'TRUNCATE relsize_test; INSERT INTO relsize_test VALUES (1)');
+check_count('postgres', 'relsize_test', 1, 'rows after TRUNCATE');
+$node_primary->safe_psql('postgres',
+	'DROP TABLE relsize_test; CREATE TABLE relsize_test AS SELECT g AS id FROM generate_series(1, 100) g'
+);
+check_count('postgres', 'relsize_test', 100, 'rows after DROP and re-creation');
+
+# CREATE DATABASE copies the template's files behind smgr's back.
+$node_primary->safe_psql('template1',
+	'CREATE TABLE relsize_tmpl AS SELECT g AS id FROM generate_series(1, 1000) g'
+);
+$node_primary->safe_psql('postgres', 'CREATE DATABASE relsize_db');
+check_count('relsize_db', 'relsize_tmpl', 1000, 'rows in new database');
+
+# Change the size of the copy, then crash the standby.  Its recovery starts
+# from a restartpoint that normally precedes CREATE DATABASE, so the copy is
+# replaced once more under the sizes cached before the crash.
+$node_primary->safe_psql('relsize_db',
+	'INSERT INTO relsize_tmpl SELECT g FROM generate_series(1001, 5000) g');
+check_count('relsize_db', 'relsize_tmpl', 5000,
+	'rows in new database after extension');
+$node_standby->stop('immediate');
+$node_standby->start;
+check_count('relsize_db', 'relsize_tmpl', 5000,
+	'rows after replaying CREATE DATABASE again');
+
+# Drop and re-create the database, so that its old sizes must be forgotten.
+$node_primary->safe_psql('postgres',
+	'DROP DATABASE relsize_db; CREATE DATABASE relsize_db');
+check_count('relsize_db', 'relsize_tmpl', 1000,
+	'rows after re-creating the database');
+
+$node_standby->stop;
+$node_primary->stop;
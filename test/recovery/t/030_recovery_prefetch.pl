@@ -0,0 +1,124 @@
+# Copyright (c) 2021, PostgreSQL Global Development Group
+
+# Replay WAL with recovery_prefetch enabled, where relations whose blocks
+# the prefetcher has looked up are dropped, truncated or removed with their
+# database shortly afterwards.  Covers crash recovery and a standby.
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+if (!check_pg_config("#define HAVE_POSIX_FADVISE 1"))
+{
+	plan skip_all => 'recovery_prefetch requires posix_fadvise()';
+}
+plan tests => 6;
+
+# Modify existing blocks of some relations, then get rid of them.  Full-page
+# writes are off, so replay reads the modified blocks from disk, and those
+# are the ones the prefetcher looks up ahead of it.
+sub run_workload
+{
+	my $node = shift;
+
+	$node->safe_psql(
+		'postgres', q{
+CREATE TABLE pf_drop AS SELECT g AS id, repeat('x', 100) AS filler FROM generate_series(1, 20000) g;
+CREATE TABLE pf_trunc AS SELECT g AS id, repeat('x', 100) AS filler FROM generate_series(1, 20000) g;
+CREATE TABLE pf_vac AS SELECT g AS id, repeat('x', 100) AS filler FROM generate_series(1, 20000) g;
+});
+	$node->safe_psql('postgres', 'CREATE DATABASE pf_db');
+	$node->safe_psql('pf_db',
+		"CREATE TABLE pf_dbtab AS SELECT g AS id, repeat('x', 100) AS filler FROM generate_series(1, 20000) g"
+	);
+	$node->safe_psql('postgres', 'CHECKPOINT');
+
+	$node->safe_psql('pf_db', 'UPDATE pf_dbtab SET id = id + 1');
+	$node->safe_psql('postgres', 'DROP DATABASE pf_db');
+
+	$node->safe_psql(
+		'postgres', q{
+UPDATE pf_drop SET id = id + 1;
+DROP TABLE pf_drop;
+UPDATE pf_trunc SET id = id + 1;
+TRUNCATE pf_trunc;
+INSERT INTO pf_trunc SELECT g, 'y' FROM generate_series(1, 100) g;
+UPDATE pf_vac SET id = id + 1;
+DELETE FROM pf_vac WHERE id > 5001;
+VACUUM pf_vac;
+INSERT INTO pf_vac SELECT g, 'z' FROM generate_series(5001, 6000) g;
+});
+	return;
+}
+
+sub check_results
+{
+	my ($node, $name) = @_;
+
+	is( $node->safe_psql(
+			'postgres',
+			"SELECT to_regclass('pf_drop') IS NULL, (SELECT count(*) FROM pf_trunc), (SELECT count(*) FROM pf_vac)"
+		),
+		't|100|6000',
+		"relations intact after $name");
+	is( $node->safe_psql(
+			'postgres', "SELECT count(*) FROM pg_database WHERE datname = 'pf_db'"),
+		'0',
+		"database dropped after $name");
+	return;
+}
+
+# Crash recovery
+my $node_primary = get_new_node('primary');
+$node_primary->init(allows_streaming => 1);
+$node_primary->append_conf(
+	'postgresql.conf', q{
+autovacuum = off
+full_page_writes = off
+recovery_prefetch = on
+log_min_messages = debug1
+});
+$node_primary->start;
+
+run_workload($node_primary);
+
+my $log_offset = -s $node_primary->logfile;
+$node_primary->stop('immediate');
+$node_primary->start;
+check_results($node_primary, 'crash recovery');
+
+my ($prefetched) = slurp_file($node_primary->logfile, $log_offset) =~
+  /recovery prefetch: (\d+) prefetched/;
+cmp_ok($prefetched, '>', 0, 'blocks were prefetched during crash recovery');
+
+# Standby, which gets the same settings with the backup.  Pause replay while
+# the workload runs, so that the prefetcher has plenty of WAL to look ahead
+# into once it resumes.
+$node_primary->safe_psql('postgres', 'DROP TABLE pf_trunc, pf_vac');
+$node_primary->backup('backup');
+
+my $node_standby = get_new_node('standby');
+$node_standby->init_from_backup($node_primary, 'backup',
+	has_streaming => 1);
+$node_standby->start;
+
+$node_standby->safe_psql('postgres', 'SELECT pg_wal_replay_pause()');
+run_workload($node_primary);
+$node_primary->wait_for_catchup($node_standby, 'write',
+	$node_primary->lsn('insert'));
+$node_standby->safe_psql('postgres', 'SELECT pg_wal_replay_resume()');
+$node_primary->wait_for_catchup($node_standby, 'replay',
+	$node_primary->lsn('insert'));
+check_results($node_standby, 'replay on standby');
+
+# The standby keeps replaying normally afterwards
+$node_primary->safe_psql('postgres',
+	"INSERT INTO pf_vac SELECT g, 'w' FROM generate_series(6001, 7000) g");
+$node_primary->wait_for_catchup($node_standby, 'replay',
+	$node_primary->lsn('insert'));
+is($node_standby->safe_psql('postgres', 'SELECT count(*) FROM pf_vac'),
+	'7000', 'standby still replays after the prefetched relations are gone');
+
+$node_standby->stop;
+$node_primary->stop;
@@ -181,5 +181,32 @@ DROP TABLE prevstats;
 -- ensure that stats accessors handle NULL input correctly
 SELECT pg_stat_get_replication_slot(NULL);
 
+-- LWLock statistics
+create function wait_for_lwlock_stats(reset_after timestamptz) returns void as $$
+begin
+  -- we don't want to wait forever; loop will exit after 30 seconds
+  for i in 1 .. 300 loop
+    exit when exists (SELECT 1 FROM pg_stat_lwlock
+                       WHERE acquisitions > 0 AND stats_reset > reset_after);
+    perform pg_sleep_for('100 milliseconds');
+    perform pg_stat_clear_snapshot();
+  end loop;
+end
+$$ language plpgsql;
+
+-- the sessions above have reported their LWLock acquisitions
+SELECT wait_for_lwlock_stats('-infinity');
+SELECT count(*) > 0 AS has_acquisitions
+  FROM pg_stat_lwlock WHERE acquisitions > 0;
+
+-- resetting them moves stats_reset forward for every tranche
+SELECT max(stats_reset) AS lwlock_reset_before FROM pg_stat_lwlock \gset
+SELECT pg_stat_reset_shared('lwlock');
+\c -
+SELECT wait_for_lwlock_stats(:'lwlock_reset_before');
+SELECT bool_and(stats_reset > :'lwlock_reset_before') AS all_reset
+  FROM pg_stat_lwlock;
+DROP FUNCTION wait_for_lwlock_stats(timestamptz);
+
 
 -- End of Stats Test